@@ -11,12 +11,18 @@ android {
         minSdk = 29        // Fix: Change from 1 to 29
         consumerProguardFiles("consumer-rules.pro")
         
+        // AndroidBenchmarkRunner also runs the plain AndroidJUnit4 tests
+        testInstrumentationRunner = "androidx.benchmark.junit4.AndroidBenchmarkRunner"
+        
         ndk {
             abiFilters.add("arm64-v8a")
         }
     }
     
     ndkVersion = "26.1.10909125"
+    
+    // Benchmarks have to measure optimized native code, debug builds are -O0
+    testBuildType = "release"
 
     buildTypes {
         release {
@@ -50,4 +56,5 @@ dependencies {
     testImplementation(libs.junit)
     androidTestImplementation(libs.androidx.junit)
     androidTestImplementation(libs.androidx.espresso.core)
+    androidTestImplementation(libs.androidx.benchmark.junit4)
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+ * Quest Camera Plugin for Unity - Benchmark hooks
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.meta.questcamera.plugin
+
+import java.nio.ByteBuffer
+
+/**
+ * Natives from questcamera_benchmark.cpp (QUESTCAMERA_BENCHMARK_HOOKS). The callbacks stand in
+ * for Unity and record sensor timestamp -> callback latency. The library is loaded by
+ * QuestCameraPlugin, so touch it before calling these.
+ */
+object BenchmarkHooks {
+    // FrameCallback / StereoFrameCallback pointers for setLeftFrameCallback and friends
+    @JvmStatic
+    external fun frameCallback(): Long
+
+    @JvmStatic
+    external fun stereoFrameCallback(): Long
+
+    // [count, meanNs, maxNs]
+    @JvmStatic
+    external fun readLatency(stereo: Boolean): LongArray
+
+    // Also resets QuestCamera_GetStats
+    @JvmStatic
+    external fun resetLatency()
+
+    // Mean and p99 per stage (sensorToAcquire, acquireToCopy, combine, callback), then
+    // frames and capture drops for left and right
+    @JvmStatic
+    external fun readPipelineStats(): LongArray
+
+    // [matchedPairs, droppedFrames] from QuestCamera_GetStereoPairingStats
+    @JvmStatic
+    external fun readStereoPairing(): LongArray
+
+    @JvmStatic
+    external fun resetStereoPairing()
+
+    // QuestCamera_SetStereoOutputBuffer, null goes back to the plugin's own buffer
+    @JvmStatic
+    external fun setStereoOutputBuffer(buffer: ByteBuffer?)
+
+    // QuestCamera_StartDump / StopDump, stopDump returns the frames written
+    @JvmStatic
+    external fun startDump(path: String): Boolean
+
+    @JvmStatic
+    external fun stopDump(): Long
+
+    // QuestCamera_StartReplay without looping, poll isReplaying for the end
+    @JvmStatic
+    external fun startReplay(path: String, realTime: Boolean): Boolean
+
+    @JvmStatic
+    external fun isReplaying(): Boolean
+}
@@ -0,0 +1,336 @@
+/*
+ * Quest Camera Plugin for Unity - Pipeline benchmarks
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.meta.questcamera.plugin
+
+import android.Manifest
+import android.annotation.SuppressLint
+import android.graphics.ImageFormat
+import android.media.Image
+import android.media.ImageReader
+import android.media.ImageWriter
+import android.os.Bundle
+import android.os.SystemClock
+import android.util.Log
+import androidx.benchmark.ExperimentalBenchmarkStateApi
+import androidx.benchmark.junit4.BenchmarkRule
+import androidx.benchmark.junit4.measureRepeated
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import org.junit.After
+import org.junit.Assume.assumeTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.nio.ByteBuffer
+import java.util.concurrent.CyclicBarrier
+import kotlin.concurrent.thread
+
+/**
+ * Hot path benchmarks on synthetic NV12 frames, plus end-to-end latency with the real cameras.
+ * Run with `gradle questcameraplugin:connectedReleaseAndroidTest`. Every result is reported as
+ * ns/frame and, where a frame is copied, MB/s, both in logcat (tag QuestCameraBenchmark) and as
+ * instrumentation status next to androidx.benchmark's own output.
+ */
+@RunWith(AndroidJUnit4::class)
+class PipelineBenchmark {
+    @get:Rule
+    val benchmarkRule = BenchmarkRule()
+
+    private val instrumentation = InstrumentationRegistry.getInstrumentation()
+    private val plugin = QuestCameraPlugin.getInstance()  // Loads the native library
+
+    @After
+    fun clearCallbacks() {
+        QuestCameraPlugin.setLeftFrameCallback(0)
+        QuestCameraPlugin.setRightFrameCallback(0)
+        QuestCameraPlugin.setStereoFrameCallback(0)
+    }
+
+    // processImage's copy of the camera planes into the direct staging buffer
+    @Test
+    fun packNv12() {
+        SyntheticImageSource(WIDTH, HEIGHT).use { source ->
+            val image = source.nextImage()
+            val staging = ByteBuffer.allocateDirect(FRAME_SIZE)
+            benchmarkRule.measureRepeated {
+                plugin.packNv12(image, WIDTH, HEIGHT, staging, isLeft = true)
+            }
+            image.close()
+        }
+        report("packNv12", bytesPerIteration = FRAME_SIZE.toLong())
+    }
+
+    // One left + right pair through StereoFrameCombiner into the side-by-side buffer
+    @Test
+    fun stereoCombine() {
+        QuestCameraPlugin.nativeReserveBufferPool(WIDTH, HEIGHT)
+        QuestCameraPlugin.setStereoFrameCallback(BenchmarkHooks.stereoFrameCallback())
+        val combiner = StereoFrameCombiner()
+        val left = syntheticNv12(1)
+        val right = syntheticNv12(2)
+        var timestamp = 0L
+        benchmarkRule.measureRepeated {
+            timestamp += FRAME_INTERVAL_NS
+            combiner.onFrameAvailable(true, StereoFrameCombiner.FrameData(left, WIDTH, HEIGHT, timestamp))
+            combiner.onFrameAvailable(false, StereoFrameCombiner.FrameData(right, WIDTH, HEIGHT, timestamp))
+        }
+        combiner.clear()
+        report("stereoCombine", bytesPerIteration = 2L * FRAME_SIZE, framesPerIteration = 2)
+    }
+
+    // Both eyes submitted at once from their own threads, as the two capture threads do. Every
+    // pair has to match, into the plugin's buffer and into an external one.
+    @Test
+    fun stereoCombineOverlapping() {
+        QuestCameraPlugin.nativeReserveBufferPool(WIDTH, HEIGHT)
+        QuestCameraPlugin.setStereoFrameCallback(BenchmarkHooks.stereoFrameCallback())
+        val external = ByteBuffer.allocateDirect(2 * FRAME_SIZE)
+        try {
+            for (output in listOf(null, external)) {
+                BenchmarkHooks.setStereoOutputBuffer(output)
+                BenchmarkHooks.resetStereoPairing()
+                submitOverlappingPairs(OVERLAPPING_PAIRS)
+                val (matched, dropped) = BenchmarkHooks.readStereoPairing()
+                val target = if (output == null) "plugin buffer" else "external buffer"
+                check(matched == OVERLAPPING_PAIRS.toLong() && dropped == 0L) {
+                    "$target: $matched of $OVERLAPPING_PAIRS pairs matched, $dropped dropped"
+                }
+            }
+        } finally {
+            BenchmarkHooks.setStereoOutputBuffer(null)
+            QuestCameraPlugin.nativeClearStereoFrames()
+        }
+    }
+
+    // JNI crossing plus dispatch to a no-op Unity callback, the frame is passed by pointer
+    @Test
+    fun jniFrameCallback() {
+        QuestCameraPlugin.setLeftFrameCallback(BenchmarkHooks.frameCallback())
+        val frame = syntheticNv12(1)
+        var timestamp = 0L
+        benchmarkRule.measureRepeated {
+            timestamp += FRAME_INTERVAL_NS
+            QuestCameraPlugin.onLeftFrameAvailable(frame, WIDTH, HEIGHT, timestamp)
+        }
+        report("jniFrameCallback")
+    }
+
+    // The same call with nothing registered, i.e. the bare JNI cost
+    @Test
+    fun jniFrameNoCallback() {
+        val frame = syntheticNv12(1)
+        var timestamp = 0L
+        benchmarkRule.measureRepeated {
+            timestamp += FRAME_INTERVAL_NS
+            QuestCameraPlugin.onLeftFrameAvailable(frame, WIDTH, HEIGHT, timestamp)
+        }
+        report("jniFrameNoCallback")
+    }
+
+    // A raw dump replayed at maximum rate through the frame callbacks and the stereo combiner.
+    // The dump is recorded from synthetic frames here, a headset capture can be dropped in instead.
+    @Test
+    fun replayDump() {
+        val dump = File(instrumentation.targetContext.cacheDir, "benchmark.qcdump")
+        writeSyntheticDump(dump, REPLAY_FRAMES_PER_EYE)
+        QuestCameraPlugin.nativeReserveBufferPool(WIDTH, HEIGHT)
+        QuestCameraPlugin.setLeftFrameCallback(BenchmarkHooks.frameCallback())
+        QuestCameraPlugin.setRightFrameCallback(BenchmarkHooks.frameCallback())
+        QuestCameraPlugin.setStereoFrameCallback(BenchmarkHooks.stereoFrameCallback())
+        benchmarkRule.measureRepeated {
+            check(BenchmarkHooks.startReplay(dump.path, false)) { "Replay failed to start" }
+            while (BenchmarkHooks.isReplaying()) {
+                Thread.yield()
+            }
+        }
+        dump.delete()
+        report(
+            "replayDump",
+            bytesPerIteration = 2L * REPLAY_FRAMES_PER_EYE * FRAME_SIZE,
+            framesPerIteration = 2 * REPLAY_FRAMES_PER_EYE
+        )
+    }
+
+    // Sensor timestamp -> Unity callback with the passthrough cameras, skipped where there are none
+    @SuppressLint("MissingPermission")
+    @Test
+    fun endToEndCameraLatency() {
+        grantCameraPermissions()
+        assumeTrue("No passthrough cameras", plugin.initialize(instrumentation.targetContext))
+
+        QuestCameraPlugin.setLeftFrameCallback(BenchmarkHooks.frameCallback())
+        QuestCameraPlugin.setRightFrameCallback(BenchmarkHooks.frameCallback())
+        QuestCameraPlugin.setStereoFrameCallback(BenchmarkHooks.stereoFrameCallback())
+        assumeTrue("Cameras failed to start", plugin.startDualCamera())
+        try {
+            // Skip session startup, then measure a steady-state window
+            Thread.sleep(CAMERA_WARMUP_MS)
+            BenchmarkHooks.resetLatency()
+            Thread.sleep(CAMERA_MEASURE_MS)
+        } finally {
+            plugin.stopDualCamera()
+        }
+
+        val mono = BenchmarkHooks.readLatency(false)
+        val stereo = BenchmarkHooks.readLatency(true)
+        val stages = BenchmarkHooks.readPipelineStats()
+        val results = Bundle()
+        results.putLong("endToEnd_frames", mono[0])
+        results.putLong("endToEnd_frameLatencyMeanNs", mono[1])
+        results.putLong("endToEnd_frameLatencyMaxNs", mono[2])
+        results.putLong("endToEnd_stereoPairs", stereo[0])
+        results.putLong("endToEnd_stereoLatencyMeanNs", stereo[1])
+        results.putLong("endToEnd_stereoLatencyMaxNs", stereo[2])
+        STAGE_NAMES.forEachIndexed { index, stage ->
+            results.putLong("endToEnd_${stage}MeanNs", stages[index * 2])
+            results.putLong("endToEnd_${stage}P99Ns", stages[index * 2 + 1])
+        }
+        results.putLong("endToEnd_leftCaptureDrops", stages[10])
+        results.putLong("endToEnd_rightCaptureDrops", stages[11])
+        val fps = mono[0] * 1000.0 / CAMERA_MEASURE_MS / 2
+        Log.i(TAG, "endToEnd: %.1f fps per eye, frame latency mean %d ns max %d ns, stereo mean %d ns"
+            .format(fps, mono[1], mono[2], stereo[1]))
+        instrumentation.sendStatus(STATUS_CODE, results)
+    }
+
+    @OptIn(ExperimentalBenchmarkStateApi::class)
+    private fun report(name: String, bytesPerIteration: Long = 0, framesPerIteration: Int = 1) {
+        val times = benchmarkRule.getState().getMeasurementTimeNs().sorted()
+        val medianNs = times[times.size / 2]
+        val nsPerFrame = medianNs / framesPerIteration
+        val results = Bundle()
+        results.putDouble("${name}_nsPerFrame", nsPerFrame)
+        if (bytesPerIteration > 0) {
+            // bytes / ns * 1e9 / 1e6
+            val mbPerSecond = bytesPerIteration * 1000.0 / medianNs
+            results.putDouble("${name}_MBps", mbPerSecond)
+            Log.i(TAG, "%s: %.0f ns/frame, %.1f MB/s".format(name, nsPerFrame, mbPerSecond))
+        } else {
+            Log.i(TAG, "%s: %.0f ns/frame".format(name, nsPerFrame))
+        }
+        instrumentation.sendStatus(STATUS_CODE, results)
+    }
+
+    private fun grantCameraPermissions() {
+        val packageName = instrumentation.targetContext.packageName
+        for (permission in listOf(Manifest.permission.CAMERA, HEADSET_CAMERA_PERMISSION)) {
+            try {
+                instrumentation.uiAutomation.grantRuntimePermission(packageName, permission)
+            } catch (e: Exception) {
+                // HEADSET_CAMERA only exists on Horizon OS
+                Log.w(TAG, "Could not grant $permission: ${e.message}")
+            }
+        }
+    }
+
+    // Feeds synthetic pairs through the JNI frame entry points while a dump is running
+    private fun writeSyntheticDump(file: File, framesPerEye: Int) {
+        check(BenchmarkHooks.startDump(file.path)) { "Dump failed to start" }
+        val left = syntheticNv12(1)
+        val right = syntheticNv12(2)
+        var timestamp = System.currentTimeMillis() * 1_000_000L
+        repeat(framesPerEye) {
+            timestamp += FRAME_INTERVAL_NS
+            QuestCameraPlugin.onLeftFrameAvailable(left, WIDTH, HEIGHT, timestamp)
+            QuestCameraPlugin.onRightFrameAvailable(right, WIDTH, HEIGHT, timestamp)
+            // Give the writer time, the dump drops frames rather than blocking
+            Thread.sleep(DUMP_FRAME_PACING_MS)
+        }
+        val written = BenchmarkHooks.stopDump()
+        check(written == 2L * framesPerEye) { "Dump wrote $written of ${2 * framesPerEye} frames" }
+    }
+
+    // Left and right of each pair are released together, so their copies overlap
+    private fun submitOverlappingPairs(pairs: Int) {
+        val barrier = CyclicBarrier(2)
+        val eyes = listOf(true, false).map { isLeft ->
+            thread(name = if (isLeft) "OverlapLeft" else "OverlapRight") {
+                val combiner = StereoFrameCombiner()
+                val frame = syntheticNv12(if (isLeft) 1 else 2)
+                var timestamp = 0L
+                repeat(pairs) {
+                    timestamp += FRAME_INTERVAL_NS
+                    barrier.await()
+                    combiner.onFrameAvailable(isLeft, StereoFrameCombiner.FrameData(frame, WIDTH, HEIGHT, timestamp))
+                }
+            }
+        }
+        eyes.forEach { it.join() }
+    }
+
+    private fun syntheticNv12(seed: Int): ByteBuffer {
+        val buffer = ByteBuffer.allocateDirect(FRAME_SIZE)
+        for (i in 0 until FRAME_SIZE) {
+            buffer.put(i, (i * seed + i / WIDTH).toByte())
+        }
+        return buffer
+    }
+
+    /**
+     * ImageWriter -> ImageReader round trip, so packNv12 reads the same kind of Image
+     * processImage gets from the camera, with the reader's real plane strides.
+     */
+    private class SyntheticImageSource(width: Int, height: Int) : AutoCloseable {
+        private val reader = ImageReader.newInstance(width, height, ImageFormat.YUV_420_888, 2)
+        private val writer = ImageWriter.newInstance(reader.surface, 2, ImageFormat.YUV_420_888)
+
+        fun nextImage(): Image {
+            val input = writer.dequeueInputImage()
+            input.planes.forEachIndexed { index, plane ->
+                val buffer = plane.buffer
+                for (i in 0 until buffer.remaining()) {
+                    buffer.put(i, (i + index * 64).toByte())
+                }
+            }
+            input.timestamp = SystemClock.elapsedRealtimeNanos()
+            writer.queueInputImage(input)
+
+            // Delivery to the reader is asynchronous
+            repeat(IMAGE_WAIT_ATTEMPTS) {
+                reader.acquireNextImage()?.let { return it }
+                Thread.sleep(10)
+            }
+            error("Synthetic frame never reached the ImageReader")
+        }
+
+        override fun close() {
+            writer.close()
+            reader.close()
+        }
+    }
+
+    companion object {
+        private const val TAG = "QuestCameraBenchmark"
+        private const val STATUS_CODE = 2
+
+        // Quest 3 passthrough stream, NV12
+        private const val WIDTH = 1280
+        private const val HEIGHT = 960
+        private const val FRAME_SIZE = WIDTH * HEIGHT * 3 / 2
+        private const val FRAME_INTERVAL_NS = 33_333_333L
+
+        private const val HEADSET_CAMERA_PERMISSION = "horizonos.permission.HEADSET_CAMERA"
+        private const val CAMERA_WARMUP_MS = 2_000L
+        private const val CAMERA_MEASURE_MS = 5_000L
+        private const val IMAGE_WAIT_ATTEMPTS = 100
+        private const val REPLAY_FRAMES_PER_EYE = 30
+        private const val DUMP_FRAME_PACING_MS = 20L
+        private const val OVERLAPPING_PAIRS = 300
+        private val STAGE_NAMES = listOf("sensorToAcquire", "acquireToCopy", "combine", "callback")
+    }
+}
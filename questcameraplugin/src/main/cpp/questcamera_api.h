@@ -0,0 +1,363 @@
+/*
+ * Quest Camera Plugin for Unity - Exported C API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Plain C exports of libquestcameraplugin, called from Unity with
+// [DllImport("questcameraplugin")]. Everything else goes through JNI.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QUESTCAMERA_EXPORT __attribute__((visibility("default")))
+
+typedef struct QuestCameraStereoPairingStats {
+    uint64_t matchedPairs;
+    uint64_t droppedFrames;  // Frames that never found a partner within the tolerance
+    int64_t meanSkewNs;      // Over matched pairs
+    int64_t maxSkewNs;
+    int64_t toleranceNs;
+} QuestCameraStereoPairingStats;
+
+typedef struct QuestCameraBufferPoolStats {
+    int32_t slabCount;
+    int32_t slabsInUse;      // Occupancy
+    int32_t peakSlabsInUse;
+    int64_t poolBytes;
+    uint64_t hits;           // Buffers served by an existing slab
+    uint64_t misses;         // Buffers that needed a new slab or a heap fallback
+} QuestCameraBufferPoolStats;
+
+// Latency histogram of one pipeline stage. Bucket 0 counts durations below 1us,
+// bucket i durations in [2^(i-1), 2^i) us, the last bucket everything longer.
+#define QUESTCAMERA_HISTOGRAM_BUCKETS 20
+
+typedef struct QuestCameraStageStats {
+    uint64_t count;
+    int64_t meanNs;
+    int64_t maxNs;
+    int64_t p50Ns;           // Upper bound of the bucket holding the median
+    int64_t p99Ns;
+    uint64_t buckets[QUESTCAMERA_HISTOGRAM_BUCKETS];
+} QuestCameraStageStats;
+
+typedef struct QuestCameraEyeStats {
+    uint64_t frames;         // Images acquired from the camera, decimated ones included
+    uint64_t captureDrops;   // Frames skipped before acquire, from sensor timestamp gaps
+    uint64_t stereoDrops;    // Frames the combiner discarded without a partner
+    uint64_t queueDrops;     // Frames overwritten in the frame queue, since it was enabled
+} QuestCameraEyeStats;
+
+typedef struct QuestCameraStats {
+    QuestCameraStageStats sensorToAcquire;  // Sensor timestamp -> image acquired
+    QuestCameraStageStats acquireToCopy;    // Acquired -> packed for delivery
+    QuestCameraStageStats combine;          // One eye's side-by-side write and pairing
+    QuestCameraStageStats callback;         // Inside Unity callbacks, all kinds
+    QuestCameraEyeStats eyes[2];            // Left, right
+} QuestCameraStats;
+
+#define QUESTCAMERA_INTRINSICS_SIZE 5  // fx, fy, cx, cy, s
+#define QUESTCAMERA_DISTORTION_SIZE 6
+#define QUESTCAMERA_POSE_SIZE 7        // tx, ty, tz, qx, qy, qz, qw
+
+// One eye's calibration, kept in native memory for the life of the process. version
+// is 0 until a camera opened, odd while the record is being rewritten and grows by 2
+// each time the values change (a camera reopened at another resolution, or a future
+// per-frame pose update). Read the pointer directly if the version is even and the
+// same before and after; QuestCamera_CopyCalibration does that retry loop for you.
+typedef struct QuestCameraCalibration {
+    uint32_t version;
+    float intrinsics[QUESTCAMERA_INTRINSICS_SIZE];
+    float distortion[QUESTCAMERA_DISTORTION_SIZE];
+    float pose[QUESTCAMERA_POSE_SIZE];
+} QuestCameraCalibration;
+
+// Frame taken from a per-eye queue. Planes are packed NV12, UV follows Y directly.
+typedef struct QuestCameraFrame {
+    const uint8_t* data;
+    int32_t dataSize;
+    int32_t width;
+    int32_t height;
+    int64_t timestamp;
+    uint64_t sequence;       // Per-eye frame counter, gaps are dropped frames
+    uint64_t droppedFrames;  // Total frames dropped by this eye's queue
+    const float* intrinsics;
+    const float* distortion;
+    const float* pose;
+} QuestCameraFrame;
+
+// Returns a frame delivered through FrameHandleCallback to its AImageReader.
+// At most IMAGE_BUFFER_SIZE - 1 frames per eye can be held at once; holding
+// more stalls that eye. Unknown or already released handles are ignored.
+QUESTCAMERA_EXPORT void QuestCamera_ReleaseFrame(uint64_t frameHandle);
+
+// Combined stereo frames are written straight into this buffer (at least
+// 2 * width * height * 3 / 2 bytes) instead of the plugin's own. The buffer must
+// stay alive until it is replaced or cleared with nullptr; it is overwritten as
+// frames arrive, so read it inside StereoFrameCallback.
+QUESTCAMERA_EXPORT void QuestCamera_SetStereoOutputBuffer(uint8_t* buffer, int32_t capacity);
+
+// Maximum left/right timestamp difference of a stereo pair, default 5ms. <= 0 restores it.
+QUESTCAMERA_EXPORT void QuestCamera_SetStereoSyncTolerance(int64_t toleranceNs);
+QUESTCAMERA_EXPORT void QuestCamera_GetStereoPairingStats(QuestCameraStereoPairingStats* outStats);
+QUESTCAMERA_EXPORT void QuestCamera_ResetStereoPairingStats(void);
+
+// Shared slab pool behind the staging, pack, conversion and stereo buffers
+QUESTCAMERA_EXPORT void QuestCamera_GetBufferPoolStats(QuestCameraBufferPoolStats* outStats);
+
+// Gives each eye a ring of slotCount preallocated frames of width x height, filled
+// by the capture threads without ever waiting on Unity. Reconfiguring or disabling
+// invalidates frames that were already dequeued. Returns false on bad arguments.
+QUESTCAMERA_EXPORT bool QuestCamera_EnableFrameQueue(int32_t slotCount, int32_t width, int32_t height);
+QUESTCAMERA_EXPORT void QuestCamera_DisableFrameQueue(void);
+
+// Polls the newest queued frame for one eye, older queued frames are dropped.
+// The frame stays valid until the next call for the same eye. Safe to call from
+// any single thread per eye, e.g. Unity's render thread or a job.
+QUESTCAMERA_EXPORT bool QuestCamera_TryDequeueFrame(bool isLeft, QuestCameraFrame* outFrame);
+
+// Pins one eye's image thread to the CPUs in cpuMask (0 = all CPUs) and sets its
+// nice value, or SCHED_FIFO when realtimePriority > 0 and the system allows it.
+// Applied by the thread itself on its next frame, in both capture paths.
+QUESTCAMERA_EXPORT void QuestCamera_SetImageThreadConfig(bool isLeft, uint64_t cpuMask,
+                                                         int32_t niceValue, int32_t realtimePriority);
+
+// Starts count (0..8) frame workers on the CPUs in cpuMask (0 = any) at niceValue. The
+// heavy stages (conversion, rectification, pyramid, stereo combine) are then split into
+// row bands across the workers and the eye's image thread, which also takes bands, and
+// idle workers pick up the other eye's. 0, the default, runs every stage on the image thread.
+QUESTCAMERA_EXPORT bool QuestCamera_SetWorkerThreads(int32_t count, uint64_t cpuMask, int32_t niceValue);
+QUESTCAMERA_EXPORT int32_t QuestCamera_GetWorkerThreads(void);
+
+// Pixel format FrameCallback delivers. Conversion runs on the eye's image thread;
+// frame queues, stereo frames and frame handles stay NV12.
+typedef enum QuestCameraOutputFormat {
+    QUESTCAMERA_FORMAT_NV12 = 0,    // width * height * 3 / 2 bytes
+    QUESTCAMERA_FORMAT_RGBA8 = 1,   // width * height * 4 bytes
+    QUESTCAMERA_FORMAT_RGB565 = 2,  // width * height * 2 bytes, native-endian uint16
+    QUESTCAMERA_FORMAT_Y8 = 3,      // width * height bytes, luma only
+} QuestCameraOutputFormat;
+
+QUESTCAMERA_EXPORT bool QuestCamera_SetOutputFormat(int32_t format);
+
+// Luma outputs delivered through LumaOutputCallback ahead of FrameCallback
+typedef enum QuestCameraLumaOutputType {
+    QUESTCAMERA_LUMA_PYRAMID = 0,
+    QUESTCAMERA_LUMA_ROI = 1,
+} QuestCameraLumaOutputType;
+
+#define QUESTCAMERA_MAX_ROIS 4
+
+// Box-filtered luma at 1/scale resolution, scale 2 or 4; 0 or 1 turns it off
+QUESTCAMERA_EXPORT bool QuestCamera_SetPyramidScale(int32_t scale);
+// Full-resolution luma crop `index` (0..QUESTCAMERA_MAX_ROIS-1) of one eye, clamped to the
+// frame. A width or height of 0 removes it.
+QUESTCAMERA_EXPORT bool QuestCamera_SetRoi(bool isLeft, int32_t index, int32_t x, int32_t y,
+                                           int32_t width, int32_t height);
+QUESTCAMERA_EXPORT void QuestCamera_ClearRois(bool isLeft);
+QUESTCAMERA_EXPORT int32_t QuestCamera_GetOutputFormat(void);
+
+// Undistorted (and, with both calibrations known, stereo-rectified) frames delivered through
+// RectifiedFrameCallback. The remap table is built on the image thread from the published
+// calibration, again only when a calibration or the frame size changes.
+typedef enum QuestCameraRectifyMode {
+    QUESTCAMERA_RECTIFY_OFF = 0,
+    QUESTCAMERA_RECTIFY_LUMA = 1,  // Y plane only, uvData is null
+    QUESTCAMERA_RECTIFY_NV12 = 2,  // Y and interleaved UV, packed
+} QuestCameraRectifyMode;
+
+// The virtual camera the rectified images of one eye were rendered with. In stereo both
+// eyes share the intrinsics and orientation, so rows are epipolar lines and depth is
+// fx * baselineMeters / (xLeft - xRight).
+typedef struct QuestCameraRectification {
+    uint32_t version;      // Bumped by every table rebuild, 0 = none built yet
+    int32_t stereo;        // 1 when rectified against the other eye, 0 when only undistorted
+    int32_t width;
+    int32_t height;
+    float intrinsics[QUESTCAMERA_INTRINSICS_SIZE];  // fx, fy, cx, cy, s of the output; no distortion
+    float baselineMeters;  // Distance between the two optical centres, 0 unless stereo
+    float rotation[9];     // Row-major, rectified camera -> this eye's camera
+} QuestCameraRectification;
+
+QUESTCAMERA_EXPORT bool QuestCamera_SetRectification(int32_t mode);
+// Returns false until the eye's table was built by its first frame
+QUESTCAMERA_EXPORT bool QuestCamera_GetRectification(bool isLeft, QuestCameraRectification* outRectification);
+
+// Sets the stream used by the next camera start. width/height 0 keep the sensor size, fps 0
+// keeps the default AE range, format 0 is YUV_420_888 (0x23); PRIVATE (0x22) is only
+// accepted with hardware buffer output. Returns false if a passthrough camera cannot stream it.
+QUESTCAMERA_EXPORT bool QuestCamera_Configure(int32_t width, int32_t height, int32_t fps, int32_t format);
+
+// Stable pointer to one eye's calibration record, never null and never freed.
+// Meant to be fetched once and paired with the compact frame callbacks.
+QUESTCAMERA_EXPORT const QuestCameraCalibration* QuestCamera_GetCalibration(bool isLeft);
+// Consistent snapshot of the record, returns false if no calibration was published yet
+QUESTCAMERA_EXPORT bool QuestCamera_CopyCalibration(bool isLeft, QuestCameraCalibration* outCalibration);
+
+// Sensor settings of one captured frame, from its TotalCaptureResult. Rows are exposed
+// one after the other: the first row starts at sensorTimestampNs, the last one
+// rollingShutterSkewNs later, each for exposureTimeNs.
+typedef struct QuestCameraFrameMetadata {
+    int64_t timestamp;             // The frame's timestamp as the callbacks got it
+    int64_t sensorTimestampNs;     // SENSOR_TIMESTAMP, boot time
+    int64_t exposureTimeNs;
+    int64_t frameDurationNs;
+    int64_t rollingShutterSkewNs;  // 0 when the camera does not report it
+    int64_t exposureMidpointNs;    // Middle row's mid-exposure in the timestamp domain, for pose lookup
+    int32_t sensitivity;           // ISO 12232 arithmetic units
+    int32_t reserved;
+} QuestCameraFrameMetadata;
+
+// Finds the capture result of the frame with this timestamp, among the last 16 per eye.
+// Results usually arrive a few milliseconds after the image, so a lookup made inside
+// the frame callback may return false while a later one (e.g. after
+// QuestCamera_TryDequeueFrame or from the render thread) succeeds.
+QUESTCAMERA_EXPORT bool QuestCamera_GetFrameMetadata(bool isLeft, int64_t timestamp,
+                                                     QuestCameraFrameMetadata* outMetadata);
+
+// Clock of every frame timestamp: the callbacks, QuestCameraFrameMetadata, dumps and the
+// recordings' calibration track. Sensors stamp frames in CLOCK_BOOTTIME; the others are
+// reached by adding an offset measured against that clock.
+typedef enum QuestCameraTimeDomain {
+    QUESTCAMERA_TIME_DOMAIN_GLOBAL = 0,     // CLOCK_REALTIME, Unix epoch (the default)
+    QUESTCAMERA_TIME_DOMAIN_BOOTTIME = 1,   // Raw SENSOR_TIMESTAMP, SystemClock.elapsedRealtimeNanos
+    QUESTCAMERA_TIME_DOMAIN_MONOTONIC = 2,  // CLOCK_MONOTONIC, stops during suspend
+    QUESTCAMERA_TIME_DOMAIN_XR = 3,         // OpenXR XrTime: CLOCK_MONOTONIC + the XR time offset
+} QuestCameraTimeDomain;
+
+typedef struct QuestCameraTimeDomainInfo {
+    int32_t domain;             // QuestCameraTimeDomain
+    int32_t refreshIntervalMs;  // 0 = the offset is only measured when the domain is selected
+    int64_t offsetNs;           // Added to SENSOR_TIMESTAMP (boot time) to get frame timestamps
+    int64_t uncertaintyNs;      // Half the width of the clock reads the offset came from
+    int64_t estimatedAtNs;      // Boot time of the last estimate
+} QuestCameraTimeDomainInfo;
+
+// Selects the domain of frame timestamps from the next frame on. With refreshIntervalMs > 0
+// the offset is re-measured that often from the frame path: small changes (CLOCK_REALTIME
+// being slewed) are applied at most 100 us per refresh so timestamps stay monotonic, large
+// ones (a suspend for MONOTONIC/XR, a clock set for GLOBAL) at once.
+QUESTCAMERA_EXPORT bool QuestCamera_SetTimestampDomain(int32_t domain, int32_t refreshIntervalMs);
+// XrTime minus CLOCK_MONOTONIC, e.g. from xrConvertTimespecTimeToTimeKHR of a monotonic
+// timespec. 0 by default, for runtimes whose XrTime is CLOCK_MONOTONIC as on Quest.
+QUESTCAMERA_EXPORT void QuestCamera_SetXrTimeOffset(int64_t xrTimeMinusMonotonicNs);
+QUESTCAMERA_EXPORT void QuestCamera_GetTimestampDomain(QuestCameraTimeDomainInfo* outInfo);
+
+// Pipeline counters since load or the last reset. Cheap enough to poll every frame.
+QUESTCAMERA_EXPORT void QuestCamera_GetStats(QuestCameraStats* outStats);
+QUESTCAMERA_EXPORT void QuestCamera_ResetStats(void);
+
+typedef enum QuestCameraStartupState {
+    QUESTCAMERA_STARTUP_IDLE = 0,       // No start timed yet, or the cameras were stopped first
+    QUESTCAMERA_STARTUP_PENDING = 1,    // Opening, some eye has not delivered a frame yet
+    QUESTCAMERA_STARTUP_STREAMING = 2,  // Every started eye delivered its first frame
+    QUESTCAMERA_STARTUP_FAILED = 3,     // A camera or session failed, see the error callback
+} QuestCameraStartupState;
+
+// Bring-up of the last camera start. Times are nanoseconds since the start call, per eye
+// (left, right), 0 until the step was reached.
+typedef struct QuestCameraStartupTiming {
+    int32_t state;            // QuestCameraStartupState
+    uint32_t eyes;            // QUESTCAMERA_EYE_* bits being started
+    int64_t openedNs[2];      // Camera device opened
+    int64_t configuredNs[2];  // Capture session configured, repeating request sent
+    int64_t firstFrameNs[2];  // First frame acquired, time to first frame
+} QuestCameraStartupTiming;
+
+QUESTCAMERA_EXPORT void QuestCamera_GetStartupTiming(QuestCameraStartupTiming* outTiming);
+
+// Warm standby: devices, sessions and readers stay configured and only the repeating
+// request changes. standbyFps 0 stops it, otherwise the slowest AE range reaching
+// standbyFps keeps exposure converged. Resume restarts the normal request and times its
+// first frames like a camera start. Same as nativePauseCapture / nativeResumeCapture.
+QUESTCAMERA_EXPORT bool QuestCamera_PauseCapture(int32_t standbyFps);
+QUESTCAMERA_EXPORT bool QuestCamera_ResumeCapture(void);
+
+// Raw frame dump for offline tests: from now on every frame that reaches the individual
+// callbacks (either capture path) is also written, as packed NV12 with its timestamp, to
+// path by a background thread. The layout is in questcamera_dump.h. Frames are dropped,
+// never blocked on, if storage falls behind.
+QUESTCAMERA_EXPORT bool QuestCamera_StartDump(const char* path);
+// Writes what is still queued and closes the file, returns the number of frames written
+QUESTCAMERA_EXPORT uint64_t QuestCamera_StopDump(void);
+
+// Plays a dump back through FrameCallback, the compact callback and, when it has both
+// eyes, the stereo combiner, on a thread of its own. realTime keeps the recorded frame
+// spacing, otherwise frames go out as fast as the callbacks return. Timestamps are
+// shifted so the first frame is the current time; the recorded calibration is published.
+QUESTCAMERA_EXPORT bool QuestCamera_StartReplay(const char* path, bool realTime, bool loop);
+QUESTCAMERA_EXPORT void QuestCamera_StopReplay(void);
+QUESTCAMERA_EXPORT bool QuestCamera_IsReplaying(void);
+
+// Returns once every frame that was being processed when it was called has finished,
+// e.g. before freeing state a callback reads. The callback setters already do this when
+// they replace a callback. From inside a frame callback it waits for the other threads'
+// frames only.
+QUESTCAMERA_EXPORT void QuestCamera_WaitForFrameQuiescence(void);
+
+// Frame subscriptions: any number of consumers (up to QUESTCAMERA_MAX_SUBSCRIBERS), each
+// with its own eyes, format, max rate and delivery thread. A derived format is computed
+// once per frame and shared by every subscriber that asked for it. Independent of the
+// single-slot callback setters, which keep working as before.
+#define QUESTCAMERA_MAX_SUBSCRIBERS 8
+#define QUESTCAMERA_EYE_LEFT 1
+#define QUESTCAMERA_EYE_RIGHT 2
+// Subscription-only format: side-by-side NV12 pairs from the stereo combiner
+#define QUESTCAMERA_FORMAT_STEREO_NV12 0x100
+
+typedef enum QuestCameraDelivery {
+    QUESTCAMERA_DELIVER_INLINE = 0,  // On the capture thread, keep the callback short
+    QUESTCAMERA_DELIVER_WORKER = 1,  // On a thread of the subscriber's own, newest frame wins
+} QuestCameraDelivery;
+
+typedef struct QuestCameraSubscribedFrame {
+    const uint8_t* data;  // Only valid during the callback
+    int32_t dataSize;
+    int32_t width;        // 2x the eye width for stereo
+    int32_t height;
+    int32_t format;       // QuestCameraOutputFormat or QUESTCAMERA_FORMAT_STEREO_NV12
+    int32_t eye;          // 0 = left, 1 = right, 2 = stereo pair
+    uint64_t sequence;    // As in the compact callbacks
+    int64_t timestamp;
+} QuestCameraSubscribedFrame;
+
+typedef void (*QuestCameraSubscriberCallback)(const QuestCameraSubscribedFrame* frame, void* userData);
+
+typedef struct QuestCameraSubscription {
+    uint32_t eyes;        // QUESTCAMERA_EYE_* bits, ignored for stereo
+    int32_t format;
+    float maxHz;          // 0 = every frame
+    int32_t delivery;     // QuestCameraDelivery
+    QuestCameraSubscriberCallback callback;
+    void* userData;
+} QuestCameraSubscription;
+
+// Returns the subscription id (> 0), or 0 if the request is invalid or all slots are taken.
+// Ids of removed subscriptions are not handed out again.
+QUESTCAMERA_EXPORT int32_t QuestCamera_Subscribe(const QuestCameraSubscription* subscription);
+// No callback of the subscription runs once this returns. Subscribe and Unsubscribe are
+// rejected (logged, returning 0 / leaving the subscription) from any subscriber callback.
+QUESTCAMERA_EXPORT void QuestCamera_Unsubscribe(int32_t subscriptionId);
+// Frames a worker subscriber missed because it was still busy with the previous one
+QUESTCAMERA_EXPORT uint64_t QuestCamera_GetSubscriberDrops(int32_t subscriptionId);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Quest Camera Plugin for Unity - Benchmark hooks
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// JNI entry points for the androidTest benchmarks (BenchmarkHooks in PipelineBenchmark.kt).
+// They stand in for Unity: no-op callbacks that record how long after the sensor
+// timestamp each frame arrived. Built only with QUESTCAMERA_BENCHMARK_HOOKS.
+
+#define LOG_TAG "QuestCameraBenchmark"
+
+#include <jni.h>
+#include <atomic>
+#include "questcamera_common.h"
+#include "questcamera_api.h"
+#include "questcamera_clock.h"
+
+namespace {
+
+struct LatencyAccumulator {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> sumNs{0};
+    std::atomic<int64_t> maxNs{0};
+
+    void record(int64_t latencyNs) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(latencyNs, std::memory_order_relaxed);
+        int64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (latencyNs > seen &&
+               !maxNs.compare_exchange_weak(seen, latencyNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        count.store(0, std::memory_order_relaxed);
+        sumNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+};
+
+LatencyAccumulator g_frameLatency;
+LatencyAccumulator g_stereoLatency;
+
+void benchmarkFrameCallback(const uint8_t*, int32_t, int32_t, int32_t, int64_t timestamp,
+                            const float*, const float*, const float*, bool) {
+    g_frameLatency.record(questcamera::frameTimeNow() - timestamp);
+}
+
+void benchmarkStereoFrameCallback(const uint8_t*, int32_t, int32_t, int32_t, int64_t timestamp,
+                                  const float*, int32_t) {
+    g_stereoLatency.record(questcamera::frameTimeNow() - timestamp);
+}
+
+jlongArray toJavaArray(JNIEnv* env, const jlong* values, jsize count) {
+    jlongArray array = env->NewLongArray(count);
+    if (array) {
+        env->SetLongArrayRegion(array, 0, count, values);
+    }
+    return array;
+}
+
+} // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_frameCallback(JNIEnv *env, jclass clazz) {
+    FrameCallback callback = benchmarkFrameCallback;
+    return reinterpret_cast<jlong>(callback);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_stereoFrameCallback(JNIEnv *env, jclass clazz) {
+    StereoFrameCallback callback = benchmarkStereoFrameCallback;
+    return reinterpret_cast<jlong>(callback);
+}
+
+// [count, meanNs, maxNs] of sensor timestamp -> callback for mono or stereo frames
+JNIEXPORT jlongArray JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_readLatency(JNIEnv *env, jclass clazz, jboolean stereo) {
+    const LatencyAccumulator& latency = stereo ? g_stereoLatency : g_frameLatency;
+    const int64_t count = latency.count.load(std::memory_order_relaxed);
+    const jlong values[] = {
+        count,
+        count ? latency.sumNs.load(std::memory_order_relaxed) / count : 0,
+        latency.maxNs.load(std::memory_order_relaxed),
+    };
+    return toJavaArray(env, values, 3);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_resetLatency(JNIEnv *env, jclass clazz) {
+    g_frameLatency.reset();
+    g_stereoLatency.reset();
+    QuestCamera_ResetStats();
+}
+
+// Mean and p99 of each QuestCamera_GetStats stage, then frames and capture drops per eye
+JNIEXPORT jlongArray JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_readPipelineStats(JNIEnv *env, jclass clazz) {
+    QuestCameraStats stats = {};
+    QuestCamera_GetStats(&stats);
+    const jlong values[] = {
+        stats.sensorToAcquire.meanNs, stats.sensorToAcquire.p99Ns,
+        stats.acquireToCopy.meanNs, stats.acquireToCopy.p99Ns,
+        stats.combine.meanNs, stats.combine.p99Ns,
+        stats.callback.meanNs, stats.callback.p99Ns,
+        static_cast<jlong>(stats.eyes[0].frames), static_cast<jlong>(stats.eyes[1].frames),
+        static_cast<jlong>(stats.eyes[0].captureDrops), static_cast<jlong>(stats.eyes[1].captureDrops),
+    };
+    return toJavaArray(env, values, sizeof(values) / sizeof(values[0]));
+}
+
+// [matchedPairs, droppedFrames] from QuestCamera_GetStereoPairingStats
+JNIEXPORT jlongArray JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_readStereoPairing(JNIEnv *env, jclass clazz) {
+    QuestCameraStereoPairingStats stats = {};
+    QuestCamera_GetStereoPairingStats(&stats);
+    const jlong values[] = {
+        static_cast<jlong>(stats.matchedPairs), static_cast<jlong>(stats.droppedFrames),
+    };
+    return toJavaArray(env, values, 2);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_resetStereoPairing(JNIEnv *env, jclass clazz) {
+    QuestCamera_ResetStereoPairingStats();
+}
+
+// QuestCamera_SetStereoOutputBuffer on a direct buffer, null restores the plugin's own
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_setStereoOutputBuffer(
+    JNIEnv *env, jclass clazz, jobject buffer) {
+    if (buffer == nullptr) {
+        QuestCamera_SetStereoOutputBuffer(nullptr, 0);
+        return;
+    }
+    QuestCamera_SetStereoOutputBuffer(
+        static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer)),
+        static_cast<int32_t>(env->GetDirectBufferCapacity(buffer)));
+}
+
+// Dump and replay (QuestCamera_StartDump / StartReplay), so recorded frames can drive the benchmarks
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_startDump(JNIEnv *env, jclass clazz, jstring path) {
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    const bool started = QuestCamera_StartDump(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return started;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_stopDump(JNIEnv *env, jclass clazz) {
+    return static_cast<jlong>(QuestCamera_StopDump());
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_startReplay(
+    JNIEnv *env, jclass clazz, jstring path, jboolean realTime) {
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    const bool started = QuestCamera_StartReplay(pathChars, realTime, false);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return started;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_BenchmarkHooks_isReplaying(JNIEnv *env, jclass clazz) {
+    return QuestCamera_IsReplaying();
+}
+
+} // extern "C"
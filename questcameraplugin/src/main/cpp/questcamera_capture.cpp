@@ -0,0 +1,468 @@
+/*
+ * Quest Camera Plugin for Unity - Native AImageReader capture
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraCapture"
+
+#include "questcamera_capture.h"
+#include "questcamera_api.h"
+#include "questcamera_combiner.h"
+#include "questcamera_convert.h"
+#include "questcamera_dump.h"
+#include "questcamera_metadata.h"
+#include "questcamera_pool.h"
+#include "questcamera_pyramid.h"
+#include "questcamera_queue.h"
+#include "questcamera_quiesce.h"
+#include "questcamera_rectify.h"
+#include "questcamera_stats.h"
+#include "questcamera_subscribers.h"
+#include "questcamera_thread.h"
+
+#include <media/NdkImageReader.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+constexpr int kMaxHeldFrames = 8;  // Upper bound, the reader's maxImages is the real limit
+
+struct HeldFrame {
+    uint64_t handle = 0;
+    AImage* image = nullptr;
+};
+
+struct NativeReader {
+    NativeReaderConfig config;
+    AImageReader* reader = nullptr;
+    PooledBuffer packBuffer;  // Only used when the planes are not already contiguous NV12
+
+    // Images handed out through FrameHandleCallback, returned by QuestCamera_ReleaseFrame
+    std::mutex heldMutex;
+    HeldFrame held[kMaxHeldFrames];
+    uint64_t nextSerial = 1;
+    bool acceptingHandles = false;
+};
+
+NativeReader g_readers[2];
+std::mutex g_readerMutex;  // Guards create/destroy, never taken on the frame path
+
+std::atomic<bool> g_individualCallbacks{true};
+std::atomic<bool> g_stereoCombining{false};
+
+// Slack on the max rate interval, sensor timestamps jitter by a few hundred microseconds
+constexpr int64_t kRateSlackNs = 2'000'000;
+
+// Per-eye decimation, checked right after acquire so a skipped frame costs one AImage_delete.
+// The settings are written from the Kotlin side, the progress fields only by the eye's thread.
+struct FrameGate {
+    std::atomic<int32_t> everyN{1};  // 1 = every frame, 0 = only captureNextFrame requests
+    std::atomic<int64_t> minIntervalNs{0};
+    std::atomic<uint32_t> pendingCaptures{0};
+    uint32_t skipped = 0;  // Since the last admitted frame
+    int64_t lastAdmittedNs = 0;
+};
+
+FrameGate g_frameGates[2];
+
+inline int eyeIndex(bool isLeft) { return isLeft ? 0 : 1; }
+
+// A pending capture request wins over decimation and is used up by the frame it admits
+bool admitFrame(FrameGate& gate, int64_t sensorTimestampNs, uint32_t* skippedBefore) {
+    bool admit = false;
+    if (gate.pendingCaptures.load(std::memory_order_relaxed) > 0) {
+        // Only this thread decrements, so the count cannot go below zero
+        gate.pendingCaptures.fetch_sub(1, std::memory_order_relaxed);
+        admit = true;
+    } else {
+        const int32_t everyN = gate.everyN.load(std::memory_order_relaxed);
+        const int64_t minInterval = gate.minIntervalNs.load(std::memory_order_relaxed);
+        admit = everyN > 0 && gate.skipped + 1 >= static_cast<uint32_t>(everyN) &&
+                (minInterval == 0 || gate.lastAdmittedNs == 0 ||
+                 sensorTimestampNs - gate.lastAdmittedNs >= minInterval - kRateSlackNs);
+    }
+    if (!admit) {
+        ++gate.skipped;
+        return false;
+    }
+    *skippedBefore = gate.skipped;
+    gate.skipped = 0;
+    gate.lastAdmittedNs = sensorTimestampNs;
+    return true;
+}
+
+// Handle layout: [serial:56][eye:1][slot:7]. The serial makes stale handles harmless.
+inline uint64_t makeHandle(uint64_t serial, int eye, int slot) {
+    return (serial << 8) | (static_cast<uint64_t>(eye) << 7) | static_cast<uint64_t>(slot);
+}
+
+struct PlaneLayout {
+    uint8_t* yData = nullptr;
+    uint8_t* uData = nullptr;
+    uint8_t* vData = nullptr;
+    int32_t yRowStride = 0;
+    int32_t uvRowStride = 0;
+    int32_t uvPixelStride = 0;
+
+    bool isSemiPlanar() const { return uvPixelStride == 2 && vData == uData + 1; }
+};
+
+bool queryPlanes(const AImage* image, PlaneLayout* layout) {
+    int yLength = 0, uLength = 0, vLength = 0;
+    if (AImage_getPlaneData(image, 0, &layout->yData, &yLength) != AMEDIA_OK ||
+        AImage_getPlaneData(image, 1, &layout->uData, &uLength) != AMEDIA_OK ||
+        AImage_getPlaneData(image, 2, &layout->vData, &vLength) != AMEDIA_OK ||
+        AImage_getPlaneRowStride(image, 0, &layout->yRowStride) != AMEDIA_OK ||
+        AImage_getPlaneRowStride(image, 1, &layout->uvRowStride) != AMEDIA_OK ||
+        AImage_getPlanePixelStride(image, 1, &layout->uvPixelStride) != AMEDIA_OK) {
+        LOGE_THROTTLED(1000, "Failed to query image planes");
+        return false;
+    }
+    return true;
+}
+
+FrameView makeFrameView(const PlaneLayout& planes, const NativeReaderConfig& config, int64_t timestamp) {
+    FrameView view;
+    view.yData = planes.yData;
+    view.uvData = planes.uData;
+    view.vData = planes.vData;
+    view.yRowStride = planes.yRowStride;
+    view.uvRowStride = planes.uvRowStride;
+    view.uvPixelStride = planes.uvPixelStride;
+    view.width = config.width;
+    view.height = config.height;
+    view.timestamp = timestamp;
+    return view;
+}
+
+// Returns contiguous NV12 for the packed FrameCallback. On Quest the YUV_420_888 planes
+// are a tightly packed NV12 buffer (plane 2 is plane 1 shifted by one byte), so the
+// Y pointer can be handed out as-is. Any other layout is packed into scratch.
+const uint8_t* resolveNv12(const FrameView& frame, PooledBuffer& scratch, int32_t* outSize) {
+    const int32_t width = frame.width;
+    const int32_t height = frame.height;
+    const int32_t ySize = width * height;
+    const int32_t frameSize = ySize + ySize / 2;
+    *outSize = frameSize;
+
+    const bool semiPlanar = frame.isSemiPlanar();
+    if (frame.yRowStride == width && frame.uvRowStride == width && semiPlanar &&
+        frame.uvData == frame.yData + ySize) {
+        return frame.yData;
+    }
+
+    uint8_t* dst = scratch.ensure(frameSize);
+    for (int32_t row = 0; row < height; ++row) {
+        memcpy(dst + row * width, frame.yData + row * frame.yRowStride, width);
+    }
+
+    uint8_t* dstUV = dst + ySize;
+    for (int32_t row = 0; row < height / 2; ++row) {
+        if (semiPlanar) {
+            // Already interleaved, only the row padding differs
+            memcpy(dstUV + row * width, frame.uvData + row * frame.uvRowStride, width);
+        } else {
+            gatherUvRow(frame, row, dstUV + row * width);
+        }
+    }
+    return dst;
+}
+
+// Takes ownership of the image until QuestCamera_ReleaseFrame. Returns 0 if no slot is free.
+uint64_t retainImage(NativeReader& state, AImage* image) {
+    std::lock_guard<std::mutex> lock(state.heldMutex);
+    if (!state.acceptingHandles) {
+        return 0;
+    }
+    for (int slot = 0; slot < kMaxHeldFrames; ++slot) {
+        HeldFrame& frame = state.held[slot];
+        if (frame.image == nullptr) {
+            frame.image = image;
+            frame.handle = makeHandle(state.nextSerial++, eyeIndex(state.config.isLeft), slot);
+            return frame.handle;
+        }
+    }
+    return 0;
+}
+
+void onImageAvailable(void* context, AImageReader* reader) {
+    auto* state = static_cast<NativeReader*>(context);
+    FrameScope scope;
+    // Each AImageReader calls back on its own thread, so the eyes never share one
+    applyEyeThreadConfigIfChanged(state->config.isLeft);
+    TraceSection frameSection(state->config.isLeft ? "QuestCamera left frame" : "QuestCamera right frame");
+
+    AImage* image = nullptr;
+    if (AImageReader_acquireLatestImage(reader, &image) != AMEDIA_OK || !image) {
+        // AMEDIA_IMGREADER_MAX_IMAGES_ACQUIRED when the consumer holds every frame
+        return;
+    }
+    const int64_t acquireNs = bootTimeNs();
+    const NativeReaderConfig& config = state->config;
+
+    // Decimation runs before the planes are even queried
+    int64_t timestamp = 0;
+    AImage_getTimestamp(image, &timestamp);
+    uint32_t skippedBefore = 0;
+    if (!admitFrame(g_frameGates[eyeIndex(config.isLeft)], timestamp, &skippedBefore)) {
+        AImage_delete(image);
+        return;
+    }
+
+    const CameraCalibration& calibration = config.calibration;
+    // PRIVATE images have no CPU planes and only go to HardwareBufferCallback
+    const bool cpuReadable = config.format == AIMAGE_FORMAT_YUV_420_888;
+    PlaneLayout planes;
+    if (cpuReadable && !queryPlanes(image, &planes)) {
+        AImage_delete(image);
+        return;
+    }
+
+    recordFrameAcquired(config.isLeft, timestamp, acquireNs, skippedBefore);
+    timestamp = stampFrame(config.isLeft, timestamp);
+
+    if (cpuReadable) {
+        // Every CPU stage reads the planes in place, whatever their padding and pixel stride
+        FrameView view = makeFrameView(planes, config, timestamp);
+        view.sequence = nextFrameSequence(config.isLeft);
+        const bool individual = g_individualCallbacks.load(std::memory_order_relaxed);
+
+        StridedFrameCallback stridedCallback = g_stridedFrameCallback.load();
+        if (stridedCallback && individual) {
+            invokeCallback("QuestCamera strided callback", stridedCallback,
+                           planes.yData, planes.uData, planes.vData,
+                           planes.yRowStride, planes.uvRowStride, planes.uvPixelStride,
+                           config.width, config.height, timestamp,
+                           calibration.intrinsics, calibration.distortion, calibration.pose,
+                           config.isLeft);
+        }
+
+        if (individual) {
+            emitLumaOutputs(config.isLeft, view);
+            emitRectifiedFrame(config.isLeft, view);
+        }
+
+        FrameCallback callback = config.isLeft ? g_leftFrameCallback.load() : g_rightFrameCallback.load();
+        CompactFrameCallback compactCallback = g_compactFrameCallback.load();
+        bool copyRecorded = false;
+        if ((callback || compactCallback) && individual) {
+            int32_t dataSize = 0;
+            const uint8_t* frameData = nullptr;
+            {
+                TraceSection section("QuestCamera pack");
+                const OutputFormat format = outputFormat();
+                frameData = format == OutputFormat::Nv12
+                    ? resolveNv12(view, state->packBuffer, &dataSize)
+                    : convertFrame(view, format, &dataSize);
+            }
+            recordStage(Stage::AcquireToCopy, bootTimeNs() - acquireNs);
+            copyRecorded = true;
+            if (callback) {
+                invokeCallback("QuestCamera frame callback", callback, frameData, dataSize,
+                               config.width, config.height, timestamp,
+                               calibration.intrinsics, calibration.distortion, calibration.pose,
+                               config.isLeft);
+            }
+            if (compactCallback) {
+                invokeCallback("QuestCamera frame callback", compactCallback, frameData, dataSize,
+                               config.width, config.height, view.sequence, timestamp,
+                               config.isLeft);
+            }
+        }
+
+        if (individual && isFrameQueueEnabled()) {
+            enqueueFrame(config.isLeft, view, calibration);
+            if (!copyRecorded) {
+                recordStage(Stage::AcquireToCopy, bootTimeNs() - acquireNs);
+            }
+        }
+        if (individual) {
+            dumpFrame(config.isLeft, view);
+            publishEyeFrame(config.isLeft, view);
+        }
+        if (g_stereoCombining.load(std::memory_order_relaxed)) {
+            submitStereoFrame(config.isLeft, view);
+        }
+    }
+
+    // Zero-copy handoff goes last: the consumer may release the image before it returns.
+    // An image has one owner, so the GPU callback takes precedence over the plane callback.
+    HardwareBufferCallback bufferCallback = g_hardwareBufferCallback.load();
+    AHardwareBuffer* hardwareBuffer = nullptr;
+    if (bufferCallback && config.hardwareBufferOutput &&
+        AImage_getHardwareBuffer(image, &hardwareBuffer) == AMEDIA_OK && hardwareBuffer) {
+        uint64_t handle = retainImage(*state, image);
+        if (handle != 0) {
+            invokeCallback("QuestCamera hardware buffer callback", bufferCallback, handle,
+                           hardwareBuffer, config.width, config.height, timestamp,
+                           calibration.intrinsics, calibration.distortion, calibration.pose,
+                           config.isLeft);
+            return;
+        }
+        LOGW_THROTTLED(1000, "All %s frame handles are held, frame not delivered", config.isLeft ? "left" : "right");
+        AImage_delete(image);
+        return;
+    }
+    
+    FrameHandleCallback handleCallback = g_frameHandleCallback.load();
+    if (handleCallback && planes.isSemiPlanar()) {
+        uint64_t handle = retainImage(*state, image);
+        if (handle != 0) {
+            invokeCallback("QuestCamera frame handle callback", handleCallback, handle,
+                           planes.yData, planes.uData,
+                           planes.yRowStride, planes.uvRowStride, planes.uvPixelStride,
+                           config.width, config.height, timestamp,
+                           calibration.intrinsics, calibration.distortion, calibration.pose,
+                           config.isLeft);
+            return;
+        }
+        LOGW_THROTTLED(1000, "All %s frame handles are held, frame not delivered", config.isLeft ? "left" : "right");
+    }
+
+    AImage_delete(image);
+}
+
+void destroyReaderLocked(NativeReader& state) {
+    AImage* orphans[kMaxHeldFrames] = {};
+    {
+        std::lock_guard<std::mutex> lock(state.heldMutex);
+        state.acceptingHandles = false;
+        for (int slot = 0; slot < kMaxHeldFrames; ++slot) {
+            orphans[slot] = state.held[slot].image;
+            state.held[slot] = HeldFrame();
+        }
+    }
+
+    if (state.reader) {
+        // Stops the listener thread and returns every acquired image to the system
+        AImageReader_delete(state.reader);
+        state.reader = nullptr;
+    }
+
+    // Frames Unity never released; their data pointers are invalid from here on
+    for (AImage* image : orphans) {
+        if (image) {
+            AImage_delete(image);
+        }
+    }
+
+    state.packBuffer.reset();
+}
+
+} // namespace
+
+bool createNativeReader(const NativeReaderConfig& config, ANativeWindow** outWindow) {
+    std::lock_guard<std::mutex> lock(g_readerMutex);
+    NativeReader& state = g_readers[eyeIndex(config.isLeft)];
+    destroyReaderLocked(state);
+
+    // CPU reads stay enabled for YUV so the NV12 callbacks, queue and combiner keep working
+    uint64_t usage = config.format == AIMAGE_FORMAT_YUV_420_888 ? AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN : 0;
+    if (config.hardwareBufferOutput) {
+        usage |= AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
+    }
+    if (usage == 0) {
+        LOGE("Image format %d needs hardware buffer output", config.format);
+        return false;
+    }
+    
+    AImageReader* reader = nullptr;
+    media_status_t status = AImageReader_newWithUsage(config.width, config.height,
+                                                      config.format, usage,
+                                                      config.maxImages, &reader);
+    if (status != AMEDIA_OK || !reader) {
+        LOGE("AImageReader_new failed: %d", status);
+        return false;
+    }
+
+    state.config = config;
+    state.reader = reader;
+    // The listener is not set yet, so the reader thread cannot be in admitFrame
+    FrameGate& gate = g_frameGates[eyeIndex(config.isLeft)];
+    gate.skipped = 0;
+    gate.lastAdmittedNs = 0;
+    {
+        std::lock_guard<std::mutex> heldLock(state.heldMutex);
+        state.acceptingHandles = true;
+    }
+
+    AImageReader_ImageListener listener{&state, onImageAvailable};
+    status = AImageReader_setImageListener(reader, &listener);
+    if (status != AMEDIA_OK) {
+        LOGE("AImageReader_setImageListener failed: %d", status);
+        destroyReaderLocked(state);
+        return false;
+    }
+
+    ANativeWindow* window = nullptr;
+    status = AImageReader_getWindow(reader, &window);
+    if (status != AMEDIA_OK || !window) {
+        LOGE("AImageReader_getWindow failed: %d", status);
+        destroyReaderLocked(state);
+        return false;
+    }
+
+    LOGD("Created native %s image reader %dx%d (maxImages: %d, gpu: %d)",
+         config.isLeft ? "left" : "right", config.width, config.height, config.maxImages,
+         config.hardwareBufferOutput);
+    *outWindow = window;
+    return true;
+}
+
+void destroyNativeReader(bool isLeft) {
+    std::lock_guard<std::mutex> lock(g_readerMutex);
+    destroyReaderLocked(g_readers[eyeIndex(isLeft)]);
+}
+
+void setDeliveryFlags(bool individualCallbacks, bool stereoCombining) {
+    g_individualCallbacks.store(individualCallbacks, std::memory_order_relaxed);
+    g_stereoCombining.store(stereoCombining, std::memory_order_relaxed);
+}
+
+void setFrameDecimation(bool isLeft, int32_t everyN, int64_t minIntervalNs) {
+    FrameGate& gate = g_frameGates[eyeIndex(isLeft)];
+    gate.everyN.store(everyN < 0 ? 1 : everyN, std::memory_order_relaxed);
+    gate.minIntervalNs.store(minIntervalNs < 0 ? 0 : minIntervalNs, std::memory_order_relaxed);
+}
+
+void requestNextFrame(bool isLeft) {
+    g_frameGates[eyeIndex(isLeft)].pendingCaptures.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace questcamera
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_ReleaseFrame(uint64_t frameHandle) {
+    using namespace questcamera;
+    const int eye = static_cast<int>((frameHandle >> 7) & 1);
+    const int slot = static_cast<int>(frameHandle & 0x7f);
+    if (frameHandle == 0 || slot >= kMaxHeldFrames) {
+        return;
+    }
+
+    NativeReader& state = g_readers[eye];
+    AImage* image = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(state.heldMutex);
+        HeldFrame& frame = state.held[slot];
+        if (frame.handle != frameHandle) {
+            return;
+        }
+        image = frame.image;
+        frame = HeldFrame();
+    }
+    AImage_delete(image);
+}
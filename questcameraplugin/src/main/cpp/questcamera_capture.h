@@ -0,0 +1,54 @@
+/*
+ * Quest Camera Plugin for Unity - Native AImageReader capture
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/native_window.h>
+#include <media/NdkImage.h>
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+struct NativeReaderConfig {
+    bool isLeft = true;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t maxImages = 0;
+    int32_t format = AIMAGE_FORMAT_YUV_420_888;  // Or AIMAGE_FORMAT_PRIVATE with hardwareBufferOutput
+    bool hardwareBufferOutput = false;  // Also allocate GPU-sampleable buffers for HardwareBufferCallback
+    CameraCalibration calibration;
+};
+
+// Creates the per-eye AImageReader and returns its window (owned by the reader).
+// Frames are handed to the Unity FrameCallback straight from the AImage planes,
+// so nothing is allocated on the JVM per frame.
+bool createNativeReader(const NativeReaderConfig& config, ANativeWindow** outWindow);
+
+// Deletes the reader for one eye. Safe to call when no reader exists.
+void destroyNativeReader(bool isLeft);
+
+// Mirrors enableIndividualCallbacks and "stereo combining enabled with both eyes
+// active" from the Kotlin side, for frames that never reach processImage.
+void setDeliveryFlags(bool individualCallbacks, bool stereoCombining);
+
+// Admits every everyN-th frame of one eye (1 = all, 0 = only requested frames) and at most
+// one per minIntervalNs (0 = no limit). Skipped frames are deleted right after acquire.
+void setFrameDecimation(bool isLeft, int32_t everyN, int64_t minIntervalNs);
+
+// Admits the next frame of one eye whatever the decimation, once per call.
+void requestNextFrame(bool isLeft);
+
+} // namespace questcamera
@@ -0,0 +1,184 @@
+/*
+ * Quest Camera Plugin for Unity - Frame timestamp domains
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraClock"
+
+#include "questcamera_clock.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+// A refresh moves the offset by at most this much, so timestamps stay monotonic while
+// CLOCK_REALTIME is slewed. Larger differences (suspend, a clock set) are taken at once.
+constexpr int64_t kMaxSlewNs = 100'000;
+constexpr int64_t kResyncThresholdNs = 20'000'000;
+constexpr int kEstimateSamples = 5;
+
+std::atomic<int32_t> g_domain{QUESTCAMERA_TIME_DOMAIN_GLOBAL};
+std::atomic<int64_t> g_offsetNs{0};           // Boot time -> selected domain
+std::atomic<int64_t> g_xrOffsetNs{0};         // XrTime - CLOCK_MONOTONIC, set by Unity
+std::atomic<int64_t> g_refreshIntervalNs{0};  // 0 = estimated once per selection
+std::atomic<int64_t> g_nextRefreshNs{0};      // Boot time, INT64_MAX when not refreshing
+std::atomic<int64_t> g_estimatedAtNs{0};
+std::atomic<int64_t> g_uncertaintyNs{0};
+std::atomic<bool> g_estimated{false};
+std::mutex g_configMutex;  // Serializes estimates, only try-locked on the frame path
+
+int64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// Offset from CLOCK_BOOTTIME to `clock`, from the tightest of a few boot/clock/boot
+// brackets. The bracket width bounds the error, well under a microsecond in practice.
+int64_t measureOffset(clockid_t clock, int64_t* uncertaintyNs) {
+    int64_t best = 0;
+    int64_t bestWidth = INT64_MAX;
+    for (int i = 0; i < kEstimateSamples; ++i) {
+        const int64_t before = clockNs(CLOCK_BOOTTIME);
+        const int64_t value = clockNs(clock);
+        const int64_t after = clockNs(CLOCK_BOOTTIME);
+        if (after - before < bestWidth) {
+            bestWidth = after - before;
+            best = value - (before + (after - before) / 2);
+        }
+    }
+    *uncertaintyNs = bestWidth / 2;
+    return best;
+}
+
+int64_t measureDomainOffset(int32_t domain, int64_t* uncertaintyNs) {
+    switch (domain) {
+        case QUESTCAMERA_TIME_DOMAIN_BOOTTIME:
+            *uncertaintyNs = 0;
+            return 0;
+        case QUESTCAMERA_TIME_DOMAIN_MONOTONIC:
+            return measureOffset(CLOCK_MONOTONIC, uncertaintyNs);
+        case QUESTCAMERA_TIME_DOMAIN_XR:
+            return measureOffset(CLOCK_MONOTONIC, uncertaintyNs) +
+                   g_xrOffsetNs.load(std::memory_order_relaxed);
+        default:
+            return measureOffset(CLOCK_REALTIME, uncertaintyNs);
+    }
+}
+
+// Called with g_configMutex held
+void estimate(bool slew) {
+    int64_t uncertaintyNs = 0;
+    int64_t offsetNs = measureDomainOffset(g_domain.load(std::memory_order_relaxed), &uncertaintyNs);
+    if (slew) {
+        const int64_t current = g_offsetNs.load(std::memory_order_relaxed);
+        const int64_t step = offsetNs - current;
+        if (std::llabs(step) < kResyncThresholdNs) {
+            offsetNs = current + std::max(-kMaxSlewNs, std::min(kMaxSlewNs, step));
+        } else {
+            LOGW("Timestamp domain offset jumped by %lld us", static_cast<long long>(step / 1000));
+        }
+    }
+    g_offsetNs.store(offsetNs, std::memory_order_relaxed);
+    g_uncertaintyNs.store(uncertaintyNs, std::memory_order_relaxed);
+    g_estimatedAtNs.store(clockNs(CLOCK_BOOTTIME), std::memory_order_relaxed);
+    g_estimated.store(true, std::memory_order_release);
+}
+
+void reestimateLocked() {
+    estimate(false);
+    const int64_t intervalNs = g_refreshIntervalNs.load(std::memory_order_relaxed);
+    g_nextRefreshNs.store(intervalNs > 0 ? clockNs(CLOCK_BOOTTIME) + intervalNs : INT64_MAX,
+                          std::memory_order_relaxed);
+}
+
+void ensureEstimated() {
+    if (!g_estimated.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(g_configMutex);
+        if (!g_estimated.load(std::memory_order_relaxed)) {
+            reestimateLocked();
+        }
+    }
+}
+
+} // namespace
+
+int64_t toFrameTime(int64_t sensorTimestampNs) {
+    ensureEstimated();
+    // The sensor timestamp is boot time too, so the refresh check needs no clock read.
+    // Whoever gets the lock re-estimates, the other camera thread keeps the old offset.
+    if (sensorTimestampNs >= g_nextRefreshNs.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(g_configMutex, std::try_to_lock);
+        const int64_t intervalNs = g_refreshIntervalNs.load(std::memory_order_relaxed);
+        if (lock.owns_lock() && intervalNs > 0 &&
+            sensorTimestampNs >= g_nextRefreshNs.load(std::memory_order_relaxed)) {
+            g_nextRefreshNs.store(sensorTimestampNs + intervalNs, std::memory_order_relaxed);
+            estimate(true);
+        }
+    }
+    return sensorTimestampNs + g_offsetNs.load(std::memory_order_relaxed);
+}
+
+int64_t frameTimeNow() {
+    ensureEstimated();
+    return clockNs(CLOCK_BOOTTIME) + g_offsetNs.load(std::memory_order_relaxed);
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetTimestampDomain(int32_t domain, int32_t refreshIntervalMs) {
+    if (domain < QUESTCAMERA_TIME_DOMAIN_GLOBAL || domain > QUESTCAMERA_TIME_DOMAIN_XR ||
+        refreshIntervalMs < 0) {
+        LOGE("Invalid timestamp domain %d (refresh %d ms)", domain, refreshIntervalMs);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    g_domain.store(domain, std::memory_order_relaxed);
+    g_refreshIntervalNs.store(static_cast<int64_t>(refreshIntervalMs) * 1'000'000,
+                              std::memory_order_relaxed);
+    reestimateLocked();
+    LOGD("Timestamp domain %d, offset %lld ns", domain,
+         static_cast<long long>(g_offsetNs.load(std::memory_order_relaxed)));
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_SetXrTimeOffset(int64_t xrTimeMinusMonotonicNs) {
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    g_xrOffsetNs.store(xrTimeMinusMonotonicNs, std::memory_order_relaxed);
+    if (g_domain.load(std::memory_order_relaxed) == QUESTCAMERA_TIME_DOMAIN_XR) {
+        reestimateLocked();
+    }
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_GetTimestampDomain(QuestCameraTimeDomainInfo* outInfo) {
+    if (!outInfo) {
+        return;
+    }
+    ensureEstimated();
+    outInfo->domain = g_domain.load(std::memory_order_relaxed);
+    outInfo->refreshIntervalMs =
+        static_cast<int32_t>(g_refreshIntervalNs.load(std::memory_order_relaxed) / 1'000'000);
+    outInfo->offsetNs = g_offsetNs.load(std::memory_order_relaxed);
+    outInfo->uncertaintyNs = g_uncertaintyNs.load(std::memory_order_relaxed);
+    outInfo->estimatedAtNs = g_estimatedAtNs.load(std::memory_order_relaxed);
+}
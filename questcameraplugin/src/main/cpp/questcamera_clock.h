@@ -0,0 +1,31 @@
+/*
+ * Quest Camera Plugin for Unity - Frame timestamp domains
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace questcamera {
+
+// Converts a SENSOR_TIMESTAMP (CLOCK_BOOTTIME) into the selected timestamp domain, the
+// value every frame callback, the recorder and the capture metadata carry. Lock-free;
+// re-estimates the domain offset from the calling thread once per refresh interval.
+int64_t toFrameTime(int64_t sensorTimestampNs);
+
+// The current time in the selected domain, for latency measurements and replay
+int64_t frameTimeNow();
+
+} // namespace questcamera
@@ -0,0 +1,427 @@
+/*
+ * Quest Camera Plugin for Unity - Native stereo frame combiner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "StereoFrameCombiner"
+
+#include "questcamera_combiner.h"
+#include "questcamera_api.h"
+#include "questcamera_metadata.h"
+#include "questcamera_pool.h"
+#include "questcamera_stats.h"
+#include "questcamera_subscribers.h"
+#include "questcamera_workers.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace questcamera {
+namespace {
+
+constexpr int64_t kDefaultSyncToleranceNs = 5'000'000;  // 5ms
+constexpr int kPairSlots = 3;  // Side-by-side buffers, i.e. how far one eye may run ahead
+constexpr int32_t kRowsPerBand = 64;  // Plain row copies, larger bands than the compute stages
+
+struct EyeHalf {
+    bool valid = false;    // Copied into the slot and waiting for the other eye
+    bool writing = false;  // Being copied without the lock held
+    int64_t timestamp = 0;  // Set when the half is claimed, so the other eye can match it mid-copy
+    uint64_t epoch = 0;     // CombinerState::epoch the half was claimed in
+    uint32_t calibrationVersion = 0;  // Registry version the frame was captured with
+
+    bool claimed() const { return valid || writing; }
+};
+
+// One side-by-side buffer. Each eye writes its own half, so pairing is decided
+// when a frame arrives and every frame is copied exactly once. Both eyes may be
+// copying into the same slot at once; whichever finishes second emits the pair.
+struct PairSlot {
+    PooledBuffer storage;
+    EyeHalf eyes[2];
+    bool busy = false;  // Handed to StereoFrameCallback, must not be written
+    float metadata[kStereoMetadataSize] = {};
+    uint32_t packedVersions[2] = {};  // Calibration versions metadata was packed from
+
+    bool isIdle() const {
+        return !busy && !eyes[0].claimed() && !eyes[1].claimed();
+    }
+};
+
+struct PairingStats {
+    uint64_t matchedPairs = 0;
+    uint64_t droppedFrames = 0;
+    int64_t skewSumNs = 0;
+    int64_t maxSkewNs = 0;
+};
+
+// The mutex only covers pairing bookkeeping. Copies and the Unity callback run
+// without it, so neither eye ever waits for the other one or for Unity.
+struct CombinerState {
+    std::mutex mutex;
+    PairSlot slots[kPairSlots];
+    int32_t width = 0;   // Per-eye size of the frames currently in the slots
+    int32_t height = 0;
+    uint64_t epoch = 0;  // Bumped whenever pending halves are invalidated
+    uint64_t nextPairSequence = 0;
+    int64_t toleranceNs = kDefaultSyncToleranceNs;
+    uint8_t* externalBuffer = nullptr;
+    int32_t externalCapacity = 0;
+    PairingStats stats;
+};
+
+CombinerState g_combiner;
+
+void invalidatePendingLocked(CombinerState& state) {
+    for (PairSlot& slot : state.slots) {
+        slot.eyes[0].valid = false;
+        slot.eyes[1].valid = false;
+    }
+    ++state.epoch;
+}
+
+bool anyWritingLocked(const CombinerState& state) {
+    for (const PairSlot& slot : state.slots) {
+        if (slot.eyes[0].writing || slot.eyes[1].writing) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 64 bytes per iteration, rows are 1280 bytes on Quest so the tail is rarely hit
+inline void copyRow(uint8_t* dst, const uint8_t* src, int32_t length) {
+#if defined(__ARM_NEON)
+    int32_t i = 0;
+    for (; i + 64 <= length; i += 64) {
+        uint8x16x4_t block = vld1q_u8_x4(src + i);
+        vst1q_u8_x4(dst + i, block);
+    }
+    for (; i + 16 <= length; i += 16) {
+        vst1q_u8(dst + i, vld1q_u8(src + i));
+    }
+    if (i < length) {
+        memcpy(dst + i, src + i, length - i);
+    }
+#else
+    memcpy(dst, src, length);
+#endif
+}
+
+inline bool externalBufferFits(const CombinerState& state, int32_t size) {
+    return state.externalBuffer && state.externalCapacity >= size;
+}
+
+// A caller-supplied buffer is a single slot, so there is no pairing history with it.
+// Both eyes of a pair still share it, the second one matches the first at claim time.
+inline int slotCountLocked(const CombinerState& state, int32_t size) {
+    return externalBufferFits(state, size) ? 1 : kPairSlots;
+}
+
+uint8_t* slotBufferLocked(CombinerState& state, PairSlot& slot, int32_t size) {
+    if (externalBufferFits(state, size)) {
+        return state.externalBuffer;
+    }
+    return slot.storage.ensure(size);
+}
+
+// Timestamp of the single half waiting in an open slot
+inline int64_t pendingTimestamp(const PairSlot& slot) {
+    return slot.eyes[0].valid ? slot.eyes[0].timestamp : slot.eyes[1].timestamp;
+}
+
+// A slot only holding finished, unmatched halves, which may be given up for a new frame
+inline bool isEvictable(const PairSlot& slot) {
+    return !slot.busy && !slot.eyes[0].writing && !slot.eyes[1].writing &&
+           (slot.eyes[0].valid || slot.eyes[1].valid);
+}
+
+// Picks the slot the arriving half goes into, or nullptr to drop the frame:
+// 1. the other eye's frame closest in time, within the tolerance, whether it is still
+//    being copied or already waiting
+// 2. an idle slot
+// 3. the slot holding the oldest unmatched frame, which is given up
+PairSlot* selectSlotLocked(CombinerState& state, int eye, int64_t timestamp, int slotCount,
+                           bool* matched) {
+    const int other = 1 - eye;
+    PairSlot* best = nullptr;
+    int64_t bestSkew = 0;
+    PairSlot* idle = nullptr;
+    PairSlot* oldest = nullptr;
+
+    for (int i = 0; i < slotCount; ++i) {
+        PairSlot& slot = state.slots[i];
+        if (slot.busy) {
+            continue;
+        }
+
+        const EyeHalf& waiting = slot.eyes[other];
+        if (waiting.claimed() && waiting.epoch == state.epoch && !slot.eyes[eye].claimed()) {
+            const int64_t skew = std::llabs(waiting.timestamp - timestamp);
+            if (skew < state.toleranceNs) {
+                if (!best || skew < bestSkew) {
+                    best = &slot;
+                    bestSkew = skew;
+                }
+                continue;
+            }
+            if (waiting.valid && waiting.timestamp < timestamp) {
+                // This eye's frames only get newer, the waiting frame can never pair.
+                // A half still being copied is left to its writer and evicted later.
+                slot.eyes[other].valid = false;
+                ++state.stats.droppedFrames;
+                recordStereoDrop(other == 0);
+            }
+        }
+
+        if (slot.isIdle()) {
+            idle = idle ? idle : &slot;
+            continue;
+        }
+
+        if (isEvictable(slot) && (!oldest || pendingTimestamp(slot) < pendingTimestamp(*oldest))) {
+            oldest = &slot;
+        }
+    }
+
+    *matched = best != nullptr;
+    if (best) {
+        return best;
+    }
+    if (idle) {
+        return idle;
+    }
+    if (oldest) {
+        for (int i = 0; i < 2; ++i) {
+            if (oldest->eyes[i].valid) {
+                recordStereoDrop(i == 0);
+            }
+        }
+        oldest->eyes[0].valid = false;
+        oldest->eyes[1].valid = false;
+        ++state.stats.droppedFrames;
+        return oldest;
+    }
+    ++state.stats.droppedFrames;
+    recordStereoDrop(eye == 0);
+    return nullptr;
+}
+
+// Calibration is constant for a session, so a slot is only repacked when the
+// registry version of either eye moved since it was last packed
+void packEyeMetadataLocked(PairSlot& slot, int eye, uint32_t version) {
+    if (slot.packedVersions[eye] == version && version != 0) {
+        return;
+    }
+    CameraCalibration calibration;
+    slot.packedVersions[eye] = readCalibration(eye == 0, &calibration);
+    float* dst = slot.metadata + eye * kEyeMetadataSize;
+    memcpy(dst, calibration.intrinsics, sizeof(calibration.intrinsics));
+    memcpy(dst + kIntrinsicsSize, calibration.distortion, sizeof(calibration.distortion));
+    memcpy(dst + kIntrinsicsSize + kDistortionSize, calibration.pose, sizeof(calibration.pose));
+}
+
+} // namespace
+
+void writeEyeSideBySide(const FrameView& frame, bool isLeft, uint8_t* dst) {
+    const int32_t width = frame.width;
+    const int32_t height = frame.height;
+    const int32_t combinedWidth = width * 2;
+    const int32_t eyeOffset = isLeft ? 0 : width;
+
+    // Interleaved UV rows are the same byte width as Y rows, so both planes are one
+    // range of rows for the frame workers: Y rows first, then the UV rows
+    uint8_t* dstY = dst + eyeOffset;
+    uint8_t* dstUV = dst + combinedWidth * height + eyeOffset;
+    const bool semiPlanar = frame.isSemiPlanar();
+    parallelFor(height + height / 2, kRowsPerBand, [&](int32_t begin, int32_t end) {
+        for (int32_t row = begin; row < end; ++row) {
+            if (row < height) {
+                copyRow(dstY + row * combinedWidth, frame.yData + row * frame.yRowStride, width);
+                continue;
+            }
+            const int32_t uvRow = row - height;
+            if (semiPlanar) {
+                copyRow(dstUV + uvRow * combinedWidth, frame.uvData + uvRow * frame.uvRowStride, width);
+            } else {
+                gatherUvRow(frame, uvRow, dstUV + uvRow * combinedWidth);
+            }
+        }
+    });
+}
+
+void submitStereoFrame(bool isLeft, const FrameView& frame) {
+    TraceSection section("QuestCamera combine");
+    StageTimer combineTimer(Stage::Combine);
+    CombinerState& state = g_combiner;
+    const int eye = isLeft ? 0 : 1;
+    const int32_t combinedWidth = frame.width * 2;
+    const int32_t combinedSize = combinedWidth * frame.height * 3 / 2;
+
+    PairSlot* slot = nullptr;
+    uint8_t* combined = nullptr;
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (frame.width != state.width || frame.height != state.height) {
+            // First frame or a resolution change, pending halves are no longer usable.
+            // Resizing would pull a buffer out from under the other eye's copy, so the
+            // frame is dropped and the next one retries the switch.
+            if (anyWritingLocked(state)) {
+                ++state.stats.droppedFrames;
+                recordStereoDrop(isLeft);
+                return;
+            }
+            invalidatePendingLocked(state);
+            state.width = frame.width;
+            state.height = frame.height;
+        }
+
+        bool matched = false;
+        slot = selectSlotLocked(state, eye, frame.timestamp, slotCountLocked(state, combinedSize),
+                                &matched);
+        if (!slot) {
+            return;
+        }
+        combined = slotBufferLocked(state, *slot, combinedSize);
+        EyeHalf& claimed = slot->eyes[eye];
+        claimed.writing = true;
+        claimed.timestamp = frame.timestamp;
+        claimed.epoch = state.epoch;
+        epoch = state.epoch;
+    }
+
+    writeEyeSideBySide(frame, isLeft, combined);
+
+    int64_t pairTimestamp = 0;
+    uint64_t pairSequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        EyeHalf& current = slot->eyes[eye];
+        current.writing = false;
+        if (epoch != state.epoch) {
+            return;
+        }
+        current.valid = true;
+        current.calibrationVersion = calibrationVersion(isLeft);
+
+        // If the other half is still being copied, its writer emits the pair
+        const EyeHalf& left = slot->eyes[0];
+        const EyeHalf& right = slot->eyes[1];
+        if (!left.valid || !right.valid) {
+            return;
+        }
+
+        const int64_t skew = std::llabs(left.timestamp - right.timestamp);
+        ++state.stats.matchedPairs;
+        state.stats.skewSumNs += skew;
+        state.stats.maxSkewNs = std::max(state.stats.maxSkewNs, skew);
+
+        packEyeMetadataLocked(*slot, 0, left.calibrationVersion);
+        packEyeMetadataLocked(*slot, 1, right.calibrationVersion);
+        pairTimestamp = left.timestamp;
+        pairSequence = state.nextPairSequence++;
+        slot->busy = true;
+        slot->eyes[0].valid = false;
+        slot->eyes[1].valid = false;
+    }
+
+    combineTimer.stop();
+    StereoFrameCallback callback = g_stereoFrameCallback.load();
+    if (callback) {
+        invokeCallback("QuestCamera stereo callback", callback, combined, combinedSize,
+                       combinedWidth, frame.height, pairTimestamp,
+                       static_cast<const float*>(slot->metadata), kStereoMetadataSize);
+    }
+    CompactStereoFrameCallback compactCallback = g_compactStereoFrameCallback.load();
+    if (compactCallback) {
+        invokeCallback("QuestCamera stereo callback", compactCallback, combined, combinedSize,
+                       combinedWidth, frame.height, pairSequence, pairTimestamp);
+    }
+    publishStereoFrame(combined, combinedSize, combinedWidth, frame.height, pairSequence, pairTimestamp);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    slot->busy = false;
+}
+
+void clearStereoFrames() {
+    std::lock_guard<std::mutex> lock(g_combiner.mutex);
+    invalidatePendingLocked(g_combiner);
+}
+
+void setStereoOutputBuffer(uint8_t* buffer, int32_t capacity) {
+    CombinerState& state = g_combiner;
+    // The caller may free the old buffer as soon as this returns, wait for writers to leave it
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            bool idle = !anyWritingLocked(state);
+            for (const PairSlot& slot : state.slots) {
+                idle = idle && !slot.busy;
+            }
+            if (idle) {
+                state.externalBuffer = buffer;
+                state.externalCapacity = buffer ? capacity : 0;
+                // A half written into the previous buffer is not in the new one
+                invalidatePendingLocked(state);
+                return;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void setStereoSyncTolerance(int64_t toleranceNs) {
+    std::lock_guard<std::mutex> lock(g_combiner.mutex);
+    g_combiner.toleranceNs = toleranceNs > 0 ? toleranceNs : kDefaultSyncToleranceNs;
+}
+
+} // namespace questcamera
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_SetStereoOutputBuffer(uint8_t* buffer, int32_t capacity) {
+    LOGD("Setting stereo output buffer: %p (%d bytes)", buffer, capacity);
+    questcamera::setStereoOutputBuffer(buffer, capacity);
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_SetStereoSyncTolerance(int64_t toleranceNs) {
+    LOGD("Setting stereo sync tolerance: %lld ns", static_cast<long long>(toleranceNs));
+    questcamera::setStereoSyncTolerance(toleranceNs);
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_GetStereoPairingStats(QuestCameraStereoPairingStats* outStats) {
+    if (!outStats) {
+        return;
+    }
+    using questcamera::g_combiner;
+    std::lock_guard<std::mutex> lock(g_combiner.mutex);
+    const auto& stats = g_combiner.stats;
+    outStats->matchedPairs = stats.matchedPairs;
+    outStats->droppedFrames = stats.droppedFrames;
+    outStats->meanSkewNs = stats.matchedPairs ? stats.skewSumNs / static_cast<int64_t>(stats.matchedPairs) : 0;
+    outStats->maxSkewNs = stats.maxSkewNs;
+    outStats->toleranceNs = g_combiner.toleranceNs;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_ResetStereoPairingStats(void) {
+    using questcamera::g_combiner;
+    std::lock_guard<std::mutex> lock(g_combiner.mutex);
+    g_combiner.stats = {};
+}
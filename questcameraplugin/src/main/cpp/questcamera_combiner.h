@@ -0,0 +1,47 @@
+/*
+ * Quest Camera Plugin for Unity - Native stereo frame combiner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Stereo metadata passed to StereoFrameCallback: left [0-17], right [18-35]
+constexpr int kEyeMetadataSize = kIntrinsicsSize + kDistortionSize + kPoseSize;
+constexpr int kStereoMetadataSize = kEyeMetadataSize * 2;
+
+// Copies one eye into its half of a side-by-side NV12 frame of width 2 * frame.width.
+void writeEyeSideBySide(const FrameView& frame, bool isLeft, uint8_t* dst);
+
+// Each eye is written into a side-by-side slot as soon as it arrives: next to the
+// other eye's nearest pending frame if one is within the sync tolerance, else into
+// a free slot to wait for its partner. StereoFrameCallback fires when a slot has
+// both halves. Called from either capture path (Kotlin processImage or native AImageReader).
+// Calibration for the stereo metadata comes from the registry in questcamera_metadata.h.
+void submitStereoFrame(bool isLeft, const FrameView& frame);
+
+// Drops pending halves, e.g. when a camera stops.
+void clearStereoFrames();
+
+// Writes combined frames straight into a caller-owned buffer instead of the internal
+// one. Pass nullptr to go back to the internal buffer.
+void setStereoOutputBuffer(uint8_t* buffer, int32_t capacity);
+
+// Maximum timestamp difference for two frames to form a pair, <= 0 restores the default
+void setStereoSyncTolerance(int64_t toleranceNs);
+
+} // namespace questcamera
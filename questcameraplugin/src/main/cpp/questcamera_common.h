@@ -0,0 +1,176 @@
+/*
+ * Quest Camera Plugin for Unity - Shared native declarations
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_log.h"
+
+#include <android/hardware_buffer.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Unity callback function pointers
+typedef void (*FrameCallback)(const uint8_t* frameData, int32_t dataSize,
+                             int32_t width, int32_t height, int64_t timestamp,
+                             const float* intrinsics, const float* distortion,
+                             const float* pose, bool isLeft);
+typedef void (*ErrorCallback)(const char* errorMessage);
+
+// Stereo frame callback
+typedef void (*StereoFrameCallback)(const uint8_t* frameData, int32_t dataSize,
+                                   int32_t width, int32_t height, int64_t timestamp,
+                                   const float* stereoMetadata, int32_t metadataSize);
+
+// Zero-copy frame callback (native capture only). The planes stay valid until
+// QuestCamera_ReleaseFrame(frameHandle) is called; UV is interleaved NV12, V = U + 1.
+typedef void (*FrameHandleCallback)(uint64_t frameHandle,
+                                   const uint8_t* yData, const uint8_t* uvData,
+                                   int32_t yRowStride, int32_t uvRowStride, int32_t uvPixelStride,
+                                   int32_t width, int32_t height, int64_t timestamp,
+                                   const float* intrinsics, const float* distortion,
+                                   const float* pose, bool isLeft);
+
+// GPU frame callback (native capture with hardware buffer output). The buffer can be
+// imported as a Vulkan/GLES external image and stays valid until
+// QuestCamera_ReleaseFrame(frameHandle); acquire it to keep it longer.
+typedef void (*HardwareBufferCallback)(uint64_t frameHandle, AHardwareBuffer* buffer,
+                                      int32_t width, int32_t height, int64_t timestamp,
+                                      const float* intrinsics, const float* distortion,
+                                      const float* pose, bool isLeft);
+
+// Plane callback: the frame as the camera laid it out, including row padding. In native
+// capture the planes point into the camera buffer and are only valid during the call.
+typedef void (*StridedFrameCallback)(const uint8_t* yData, const uint8_t* uData, const uint8_t* vData,
+                                    int32_t yRowStride, int32_t uvRowStride, int32_t uvPixelStride,
+                                    int32_t width, int32_t height, int64_t timestamp,
+                                    const float* intrinsics, const float* distortion,
+                                    const float* pose, bool isLeft);
+
+// Downscaled luma or a full-resolution luma crop, packed (row stride == width) and only
+// valid during the call. originX/originY locate the output in full-resolution pixels and
+// scale is 1 for ROI crops, 2 or 4 for pyramid levels.
+typedef void (*LumaOutputCallback)(const uint8_t* lumaData, int32_t width, int32_t height,
+                                  int32_t outputType, int32_t outputIndex,
+                                  int32_t originX, int32_t originY, int32_t scale,
+                                  int64_t timestamp, bool isLeft);
+
+// Undistorted or stereo-rectified frame, see QuestCamera_SetRectification. Packed
+// (stride == width), uvData follows yData or is null for luma only; valid during the call.
+typedef void (*RectifiedFrameCallback)(const uint8_t* yData, const uint8_t* uvData,
+                                      int32_t width, int32_t height,
+                                      uint64_t sequence, int64_t timestamp, bool isLeft);
+
+// Compact callbacks of the metadata handle model: calibration is not passed per frame
+// but read through QuestCamera_GetCalibration, only again when its version changes.
+// sequence counts every frame of that eye from 0 (a pair counter for stereo), so gaps
+// are frames this consumer never saw. Data is only valid during the call.
+typedef void (*CompactFrameCallback)(const uint8_t* frameData, int32_t dataSize,
+                                    int32_t width, int32_t height,
+                                    uint64_t sequence, int64_t timestamp, bool isLeft);
+typedef void (*CompactStereoFrameCallback)(const uint8_t* frameData, int32_t dataSize,
+                                          int32_t width, int32_t height,
+                                          uint64_t sequence, int64_t timestamp);
+
+// Once per camera start, when every started eye delivered its first frame (status
+// QUESTCAMERA_STARTUP_STREAMING) or when the start failed (QUESTCAMERA_STARTUP_FAILED).
+// Times are nanoseconds from the start call to each eye's first frame, 0 for an eye
+// that was not started or never delivered one.
+typedef void (*StartupCallback)(int32_t status, int64_t leftFirstFrameNs, int64_t rightFirstFrameNs);
+
+// Registered by Unity through the JNI setters in questcamera_jni.cpp. Frame threads load
+// each pointer once per frame inside a FrameScope; the setters wait for frame quiescence
+// after replacing one, so an old callback never runs once its setter returned.
+extern std::atomic<FrameCallback> g_leftFrameCallback;
+extern std::atomic<FrameCallback> g_rightFrameCallback;
+extern std::atomic<ErrorCallback> g_errorCallback;
+extern std::atomic<StereoFrameCallback> g_stereoFrameCallback;
+extern std::atomic<FrameHandleCallback> g_frameHandleCallback;
+extern std::atomic<HardwareBufferCallback> g_hardwareBufferCallback;
+extern std::atomic<StridedFrameCallback> g_stridedFrameCallback;
+extern std::atomic<LumaOutputCallback> g_lumaOutputCallback;
+extern std::atomic<RectifiedFrameCallback> g_rectifiedFrameCallback;
+extern std::atomic<CompactFrameCallback> g_compactFrameCallback;
+extern std::atomic<CompactStereoFrameCallback> g_compactStereoFrameCallback;
+extern std::atomic<StartupCallback> g_startupCallback;
+
+namespace questcamera {
+
+// Static per-camera calibration, same layout as CameraInfo on the Kotlin side
+constexpr int kIntrinsicsSize = 5;
+constexpr int kDistortionSize = 6;
+constexpr int kPoseSize = 7;
+
+struct CameraCalibration {
+    float intrinsics[kIntrinsicsSize] = {};
+    float distortion[kDistortionSize] = {};
+    float pose[kPoseSize] = {};
+};
+
+// Non-owning view of one YUV 4:2:0 frame, either AImage planes or a pinned ByteArray.
+// Rows may be padded. With uvPixelStride 2 and vData == uvData + 1 (or null) the chroma is
+// interleaved NV12 and rows can be copied as-is; any other layout is gathered per sample.
+struct FrameView {
+    const uint8_t* yData = nullptr;
+    const uint8_t* uvData = nullptr;  // U plane
+    const uint8_t* vData = nullptr;   // V plane, null for NV12
+    int32_t yRowStride = 0;
+    int32_t uvRowStride = 0;
+    int32_t uvPixelStride = 2;
+    int32_t width = 0;
+    int32_t height = 0;
+    int64_t timestamp = 0;
+    uint64_t sequence = 0;  // nextFrameSequence() of the eye, see CompactFrameCallback
+
+    bool isSemiPlanar() const {
+        return uvPixelStride == 2 && (vData == nullptr || vData == uvData + 1);
+    }
+};
+
+// Writes chroma row `row` of a non-NV12 layout as width interleaved UV bytes
+inline void gatherUvRow(const FrameView& frame, int32_t row, uint8_t* dst) {
+    const uint8_t* uRow = frame.uvData + row * frame.uvRowStride;
+    const uint8_t* vRow = frame.vData + row * frame.uvRowStride;
+    for (int32_t col = 0; col < frame.width / 2; ++col) {
+        dst[col * 2] = uRow[col * frame.uvPixelStride];
+        dst[col * 2 + 1] = vRow[col * frame.uvPixelStride];
+    }
+}
+
+// True when Y and UV already form one unpadded NV12 buffer starting at yData
+inline bool isPackedNv12(const FrameView& frame) {
+    return frame.yRowStride == frame.width && frame.uvRowStride == frame.width &&
+           frame.isSemiPlanar() && frame.uvData == frame.yData + frame.width * frame.height;
+}
+
+// Writes any FrameView layout as width * height * 3 / 2 bytes of packed NV12
+inline void packNv12(const FrameView& frame, uint8_t* dst) {
+    const int32_t width = frame.width;
+    for (int32_t row = 0; row < frame.height; ++row) {
+        memcpy(dst + row * width, frame.yData + row * frame.yRowStride, width);
+    }
+    uint8_t* dstUV = dst + width * frame.height;
+    const bool semiPlanar = frame.isSemiPlanar();
+    for (int32_t row = 0; row < frame.height / 2; ++row) {
+        if (semiPlanar) {
+            memcpy(dstUV + row * width, frame.uvData + row * frame.uvRowStride, width);
+        } else {
+            gatherUvRow(frame, row, dstUV + row * width);
+        }
+    }
+}
+
+} // namespace questcamera
@@ -0,0 +1,230 @@
+/*
+ * Quest Camera Plugin for Unity - NV12 color conversion
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraConvert"
+
+#include "questcamera_convert.h"
+#include "questcamera_api.h"
+#include "questcamera_pool.h"
+#include "questcamera_workers.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace questcamera {
+namespace {
+
+std::atomic<int32_t> g_outputFormat{static_cast<int32_t>(OutputFormat::Nv12)};
+
+// Each eye converts on its own image thread, so per-thread scratch needs no locking.
+// The row buffer is per band thread too, each worker gathers its own rows.
+thread_local PooledBuffer t_convertBuffer;
+thread_local std::vector<uint8_t> t_uvRowBuffer;  // Interleaved chroma for non-NV12 layouts
+
+constexpr int32_t kRowsPerBand = 32;
+
+// BT.601 full range in 6-bit fixed point, small enough for int16 lanes:
+// R = Y + 1.402 V', G = Y - 0.344 U' - 0.714 V', B = Y + 1.772 U'
+constexpr int kShift = 6;
+constexpr int16_t kVr = 90;
+constexpr int16_t kUg = 22;
+constexpr int16_t kVg = 46;
+constexpr int16_t kUb = 113;
+
+inline uint8_t clampToByte(int32_t value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+inline void convertPixel(uint8_t y, uint8_t u, uint8_t v, uint8_t* r, uint8_t* g, uint8_t* b) {
+    const int32_t yScaled = static_cast<int32_t>(y) << kShift;
+    const int32_t uc = static_cast<int32_t>(u) - 128;
+    const int32_t vc = static_cast<int32_t>(v) - 128;
+    *r = clampToByte((yScaled + kVr * vc) >> kShift);
+    *g = clampToByte((yScaled - kUg * uc - kVg * vc) >> kShift);
+    *b = clampToByte((yScaled + kUb * uc) >> kShift);
+}
+
+inline uint16_t packRgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return static_cast<uint16_t>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+#if defined(__ARM_NEON)
+struct RgbLanes {
+    uint8x16_t r;
+    uint8x16_t g;
+    uint8x16_t b;
+};
+
+// 16 pixels of one row. Each UV pair covers two horizontally adjacent pixels.
+inline RgbLanes convert16(const uint8_t* yRow, const uint8_t* uvRow) {
+    const uint8x16_t y = vld1q_u8(yRow);
+    const uint8x8x2_t uv = vld2_u8(uvRow);
+    const int16x8_t bias = vdupq_n_s16(128);
+    const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[0])), bias);
+    const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[1])), bias);
+
+    const int16x8_t rChroma = vmulq_n_s16(v, kVr);
+    const int16x8_t gChroma = vmlaq_n_s16(vmulq_n_s16(u, kUg), v, kVg);
+    const int16x8_t bChroma = vmulq_n_s16(u, kUb);
+    const int16x8x2_t r2 = vzipq_s16(rChroma, rChroma);
+    const int16x8x2_t g2 = vzipq_s16(gChroma, gChroma);
+    const int16x8x2_t b2 = vzipq_s16(bChroma, bChroma);
+
+    const int16x8_t yLow = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(y), kShift));
+    const int16x8_t yHigh = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(y), kShift));
+
+    RgbLanes out;
+    out.r = vcombine_u8(vqshrun_n_s16(vaddq_s16(yLow, r2.val[0]), kShift),
+                        vqshrun_n_s16(vaddq_s16(yHigh, r2.val[1]), kShift));
+    out.g = vcombine_u8(vqshrun_n_s16(vsubq_s16(yLow, g2.val[0]), kShift),
+                        vqshrun_n_s16(vsubq_s16(yHigh, g2.val[1]), kShift));
+    out.b = vcombine_u8(vqshrun_n_s16(vaddq_s16(yLow, b2.val[0]), kShift),
+                        vqshrun_n_s16(vaddq_s16(yHigh, b2.val[1]), kShift));
+    return out;
+}
+
+inline uint16x8_t pack565(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+    uint16x8_t packed = vshll_n_u8(r, 8);
+    packed = vsriq_n_u16(packed, vshll_n_u8(g, 8), 5);
+    return vsriq_n_u16(packed, vshll_n_u8(b, 8), 11);
+}
+#endif
+
+void convertRowRgba(const uint8_t* yRow, const uint8_t* uvRow, uint8_t* dst, int32_t width) {
+    int32_t x = 0;
+#if defined(__ARM_NEON)
+    const uint8x16_t alpha = vdupq_n_u8(255);
+    for (; x + 16 <= width; x += 16) {
+        const RgbLanes rgb = convert16(yRow + x, uvRow + x);
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgb.r;
+        rgba.val[1] = rgb.g;
+        rgba.val[2] = rgb.b;
+        rgba.val[3] = alpha;
+        vst4q_u8(dst + x * 4, rgba);
+    }
+#endif
+    for (; x < width; ++x) {
+        const int32_t uvIndex = x & ~1;
+        uint8_t* pixel = dst + x * 4;
+        convertPixel(yRow[x], uvRow[uvIndex], uvRow[uvIndex + 1], &pixel[0], &pixel[1], &pixel[2]);
+        pixel[3] = 255;
+    }
+}
+
+void convertRowRgb565(const uint8_t* yRow, const uint8_t* uvRow, uint16_t* dst, int32_t width) {
+    int32_t x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= width; x += 16) {
+        const RgbLanes rgb = convert16(yRow + x, uvRow + x);
+        vst1q_u16(dst + x, pack565(vget_low_u8(rgb.r), vget_low_u8(rgb.g), vget_low_u8(rgb.b)));
+        vst1q_u16(dst + x + 8, pack565(vget_high_u8(rgb.r), vget_high_u8(rgb.g), vget_high_u8(rgb.b)));
+    }
+#endif
+    for (; x < width; ++x) {
+        const int32_t uvIndex = x & ~1;
+        uint8_t r, g, b;
+        convertPixel(yRow[x], uvRow[uvIndex], uvRow[uvIndex + 1], &r, &g, &b);
+        dst[x] = packRgb565(r, g, b);
+    }
+}
+
+// Interleaved UV for chroma row `row`, in place for NV12 and gathered otherwise
+inline const uint8_t* chromaRow(const FrameView& frame, int32_t row, bool semiPlanar) {
+    if (semiPlanar) {
+        return frame.uvData + row * frame.uvRowStride;
+    }
+    t_uvRowBuffer.resize(frame.width);
+    gatherUvRow(frame, row, t_uvRowBuffer.data());
+    return t_uvRowBuffer.data();
+}
+
+} // namespace
+
+OutputFormat outputFormat() {
+    return static_cast<OutputFormat>(g_outputFormat.load(std::memory_order_relaxed));
+}
+
+const uint8_t* convertFrame(const FrameView& frame, OutputFormat format, int32_t* outSize) {
+    const int32_t width = frame.width;
+    const int32_t height = frame.height;
+    PooledBuffer& buffer = t_convertBuffer;
+    const bool semiPlanar = frame.isSemiPlanar();
+
+    switch (format) {
+        case OutputFormat::Y8: {
+            *outSize = width * height;
+            if (frame.yRowStride == width) {
+                return frame.yData;
+            }
+            buffer.ensure(*outSize);
+            for (int32_t row = 0; row < height; ++row) {
+                memcpy(buffer.data() + row * width, frame.yData + row * frame.yRowStride, width);
+            }
+            return buffer.data();
+        }
+        case OutputFormat::Rgba8: {
+            *outSize = width * height * 4;
+            uint8_t* dst = buffer.ensure(*outSize);
+            parallelFor(height, kRowsPerBand, [&](int32_t begin, int32_t end) {
+                for (int32_t row = begin; row < end; ++row) {
+                    convertRowRgba(frame.yData + row * frame.yRowStride,
+                                   chromaRow(frame, row / 2, semiPlanar),
+                                   dst + row * width * 4, width);
+                }
+            });
+            return buffer.data();
+        }
+        case OutputFormat::Rgb565: {
+            *outSize = width * height * 2;
+            buffer.ensure(*outSize);
+            auto* dst = reinterpret_cast<uint16_t*>(buffer.data());
+            parallelFor(height, kRowsPerBand, [&](int32_t begin, int32_t end) {
+                for (int32_t row = begin; row < end; ++row) {
+                    convertRowRgb565(frame.yData + row * frame.yRowStride,
+                                     chromaRow(frame, row / 2, semiPlanar),
+                                     dst + row * width, width);
+                }
+            });
+            return buffer.data();
+        }
+        case OutputFormat::Nv12:
+            break;
+    }
+    *outSize = 0;
+    return nullptr;
+}
+
+} // namespace questcamera
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetOutputFormat(int32_t format) {
+    if (format < QUESTCAMERA_FORMAT_NV12 || format > QUESTCAMERA_FORMAT_Y8) {
+        LOGE("Unknown output format %d", format);
+        return false;
+    }
+    LOGD("Setting output format: %d", format);
+    questcamera::g_outputFormat.store(format, std::memory_order_relaxed);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT int32_t QuestCamera_GetOutputFormat(void) {
+    return questcamera::g_outputFormat.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,40 @@
+/*
+ * Quest Camera Plugin for Unity - NV12 color conversion
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Same values as QuestCameraOutputFormat in questcamera_api.h
+enum class OutputFormat : int32_t {
+    Nv12 = 0,
+    Rgba8 = 1,
+    Rgb565 = 2,
+    Y8 = 3,
+};
+
+// Format FrameCallback receives, set with QuestCamera_SetOutputFormat
+OutputFormat outputFormat();
+
+// Converts one YUV 4:2:0 frame (BT.601 full range, any FrameView layout) into the output format on the calling
+// thread. The result lives in a per-thread pooled buffer, or points into the frame itself for
+// Y8 with unpadded rows, and stays valid until the next call on the same thread.
+// Must not be called for OutputFormat::Nv12.
+const uint8_t* convertFrame(const FrameView& frame, OutputFormat format, int32_t* outSize);
+
+} // namespace questcamera
@@ -0,0 +1,474 @@
+/*
+ * Quest Camera Plugin for Unity - Raw frame dump and replay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraDump"
+
+#include "questcamera_dump.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+#include "questcamera_clock.h"
+#include "questcamera_combiner.h"
+#include "questcamera_convert.h"
+#include "questcamera_metadata.h"
+#include "questcamera_quiesce.h"
+#include "questcamera_stats.h"
+#include "questcamera_subscribers.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace questcamera {
+namespace {
+
+constexpr size_t kDumpSlotsPerEye = 6;  // ~11MB per eye at 1280x960
+constexpr auto kWriterPollInterval = std::chrono::milliseconds(5);
+
+inline size_t paddedSize(size_t size) { return (size + 7) & ~size_t{7}; }
+
+// ---- Writer ----
+
+struct DumpSlot {
+    DumpFrameHeader header = {};
+    std::vector<uint8_t> data;  // Grown on first use, then reused
+};
+
+// Single producer (the eye's image thread), single consumer (the writer thread)
+struct EyeFifo {
+    DumpSlot slots[kDumpSlotsPerEye];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+};
+
+struct DumpWriter {
+    std::atomic<bool> active{false};
+    std::atomic<int> producers{0};  // Frame threads inside dumpFrame
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    EyeFifo eyes[2];
+    std::thread thread;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    // Writer thread only
+    int fd = -1;
+    bool headerWritten = false;
+    bool failed = false;
+};
+
+DumpWriter g_dump;
+std::mutex g_dumpControlMutex;  // Start/stop, never taken on the frame path
+
+bool writeFully(int fd, iovec* parts, int count) {
+    while (count > 0) {
+        const ssize_t n = writev(fd, parts, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t remaining = static_cast<size_t>(n);
+        while (count > 0 && remaining >= parts->iov_len) {
+            remaining -= parts->iov_len;
+            ++parts;
+            --count;
+        }
+        if (count > 0) {
+            parts->iov_base = static_cast<uint8_t*>(parts->iov_base) + remaining;
+            parts->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+// Deferred to the first frame, which fixes the size; calibration is published by then
+void writeFileHeader(DumpWriter& dump, const DumpFrameHeader& first) {
+    DumpFileHeader header = {};
+    header.magic = kDumpMagic;
+    header.version = kDumpVersion;
+    header.headerSize = sizeof(DumpFileHeader);
+    header.frameHeaderSize = sizeof(DumpFrameHeader);
+    header.width = first.width;
+    header.height = first.height;
+    for (int eye = 0; eye < 2; ++eye) {
+        CameraCalibration calibration;
+        header.calibrationVersions[eye] = readCalibration(eye == 0, &calibration);
+        memcpy(header.calibration[eye].intrinsics, calibration.intrinsics, sizeof(calibration.intrinsics));
+        memcpy(header.calibration[eye].distortion, calibration.distortion, sizeof(calibration.distortion));
+        memcpy(header.calibration[eye].pose, calibration.pose, sizeof(calibration.pose));
+    }
+    iovec part{&header, sizeof(header)};
+    dump.failed = !writeFully(dump.fd, &part, 1);
+    dump.headerWritten = true;
+}
+
+void writeSlot(DumpWriter& dump, const DumpSlot& slot) {
+    if (!dump.headerWritten) {
+        writeFileHeader(dump, slot.header);
+    }
+    if (dump.failed) {
+        // Keep draining so the frame threads never stall, the file is broken anyway
+        return;
+    }
+    static const uint8_t kPadding[8] = {};
+    const size_t dataSize = slot.header.dataSize;
+    iovec parts[3] = {
+        {const_cast<DumpFrameHeader*>(&slot.header), sizeof(DumpFrameHeader)},
+        {const_cast<uint8_t*>(slot.data.data()), dataSize},
+        {const_cast<uint8_t*>(kPadding), paddedSize(dataSize) - dataSize},
+    };
+    if (!writeFully(dump.fd, parts, 3)) {
+        LOGE("Dump write failed (%s), later frames are discarded", strerror(errno));
+        dump.failed = true;
+        return;
+    }
+    dump.written.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Writes the older queued frame of the two eyes first, so the file stays close to timestamp order
+void writerLoop(DumpWriter* dump) {
+    for (;;) {
+        // Read before the scan: producers are gone before stopping is set, so FIFOs found
+        // empty after seeing it stay empty. Read after, a frame queued between the scan and
+        // the stop would be left behind.
+        const bool stopping = dump->stopping.load();
+        int next = -1;
+        int64_t nextTimestamp = 0;
+        for (int eye = 0; eye < 2; ++eye) {
+            EyeFifo& fifo = dump->eyes[eye];
+            const uint64_t tail = fifo.tail.load(std::memory_order_relaxed);
+            if (tail == fifo.head.load(std::memory_order_acquire)) {
+                continue;
+            }
+            const int64_t timestamp = fifo.slots[tail % kDumpSlotsPerEye].header.timestampNs;
+            if (next < 0 || timestamp < nextTimestamp) {
+                next = eye;
+                nextTimestamp = timestamp;
+            }
+        }
+
+        if (next < 0) {
+            if (stopping) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(dump->wakeMutex);
+            dump->wake.wait_for(lock, kWriterPollInterval);
+            continue;
+        }
+
+        EyeFifo& fifo = dump->eyes[next];
+        const uint64_t tail = fifo.tail.load(std::memory_order_relaxed);
+        writeSlot(*dump, fifo.slots[tail % kDumpSlotsPerEye]);
+        fifo.tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+// ---- Replay ----
+
+struct ReplayState {
+    std::thread thread;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> running{false};
+    const uint8_t* map = nullptr;
+    size_t mapSize = 0;
+    std::vector<size_t> frameOffsets;
+    bool stereo = false;  // Both eyes present, so the combiner is fed too
+    bool realTime = true;
+    bool loop = false;
+};
+
+ReplayState g_replay;
+std::mutex g_replayControlMutex;
+
+void releaseReplayLocked() {
+    g_replay.stopRequested.store(true);
+    if (g_replay.thread.joinable()) {
+        g_replay.thread.join();
+    }
+    if (g_replay.map) {
+        munmap(const_cast<uint8_t*>(g_replay.map), g_replay.mapSize);
+    }
+    g_replay.map = nullptr;
+    g_replay.mapSize = 0;
+    g_replay.frameOffsets.clear();
+    g_replay.stopRequested.store(false);
+}
+
+// Walks the records once, so a truncated tail (dump that never stopped) is cut cleanly
+bool indexFrames(ReplayState& replay, const DumpFileHeader& header) {
+    bool eyes[2] = {false, false};
+    size_t offset = header.headerSize;
+    while (offset + sizeof(DumpFrameHeader) <= replay.mapSize) {
+        DumpFrameHeader frame;
+        memcpy(&frame, replay.map + offset, sizeof(frame));
+        const size_t expected = static_cast<size_t>(frame.width) * frame.height * 3 / 2;
+        const size_t dataEnd = offset + header.frameHeaderSize + frame.dataSize;
+        if (frame.magic != kDumpFrameMagic || frame.eye > 1 || frame.width <= 0 ||
+            frame.height <= 0 || frame.dataSize != expected || dataEnd > replay.mapSize) {
+            break;
+        }
+        replay.frameOffsets.push_back(offset);
+        eyes[frame.eye] = true;
+        offset += header.frameHeaderSize + paddedSize(frame.dataSize);
+    }
+    if (offset < replay.mapSize) {
+        LOGW("Dump has %zu trailing bytes that are not a frame, ignored", replay.mapSize - offset);
+    }
+    replay.stereo = eyes[0] && eyes[1];
+    return !replay.frameOffsets.empty();
+}
+
+void deliverFrame(const DumpFrameHeader& frame, const uint8_t* data, int64_t timestamp) {
+    FrameScope scope;
+    const bool isLeft = frame.eye == 0;
+    FrameView view;
+    view.yData = data;
+    view.uvData = data + frame.width * frame.height;
+    view.yRowStride = frame.width;
+    view.uvRowStride = frame.width;
+    view.width = frame.width;
+    view.height = frame.height;
+    view.timestamp = timestamp;
+    view.sequence = nextFrameSequence(isLeft);
+
+    FrameCallback callback = isLeft ? g_leftFrameCallback.load() : g_rightFrameCallback.load();
+    CompactFrameCallback compactCallback = g_compactFrameCallback.load();
+    if (callback || compactCallback) {
+        CameraCalibration calibration;
+        readCalibration(isLeft, &calibration);
+        const uint8_t* frameData = data;
+        int32_t dataSize = static_cast<int32_t>(frame.dataSize);
+        const OutputFormat format = outputFormat();
+        if (format != OutputFormat::Nv12) {
+            frameData = convertFrame(view, format, &dataSize);
+        }
+        if (callback) {
+            invokeCallback("QuestCamera frame callback", callback, frameData, dataSize,
+                           frame.width, frame.height, timestamp, calibration.intrinsics,
+                           calibration.distortion, calibration.pose, isLeft);
+        }
+        if (compactCallback) {
+            invokeCallback("QuestCamera frame callback", compactCallback, frameData, dataSize,
+                           frame.width, frame.height, view.sequence, timestamp, isLeft);
+        }
+    }
+    publishEyeFrame(isLeft, view);
+    if (g_replay.stereo) {
+        submitStereoFrame(isLeft, view);
+    }
+}
+
+// Frames are read in place from the mapping. Timestamps are shifted per pass so the
+// first frame is "now", keeping latency measurements and stereo pairing meaningful.
+void replayLoop(ReplayState* replay) {
+    DumpFrameHeader first;
+    memcpy(&first, replay->map + replay->frameOffsets.front(), sizeof(first));
+    uint64_t delivered = 0;
+    do {
+        const int64_t shiftNs = frameTimeNow() - first.timestampNs;
+        const auto passStart = std::chrono::steady_clock::now();
+        for (size_t offset : replay->frameOffsets) {
+            if (replay->stopRequested.load(std::memory_order_relaxed)) {
+                break;
+            }
+            DumpFrameHeader frame;
+            memcpy(&frame, replay->map + offset, sizeof(frame));
+            if (replay->realTime) {
+                std::this_thread::sleep_until(
+                    passStart + std::chrono::nanoseconds(frame.timestampNs - first.timestampNs));
+            }
+            deliverFrame(frame, replay->map + offset + sizeof(DumpFrameHeader),
+                         frame.timestampNs + shiftNs);
+            ++delivered;
+        }
+        clearStereoFrames();
+    } while (replay->loop && !replay->stopRequested.load(std::memory_order_relaxed));
+    LOGD("Replay finished, %llu frames delivered", static_cast<unsigned long long>(delivered));
+    replay->running.store(false);
+}
+
+} // namespace
+
+bool isDumpActive() {
+    return g_dump.active.load(std::memory_order_relaxed);
+}
+
+void dumpFrame(bool isLeft, const FrameView& frame) {
+    if (!g_dump.active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // StopDump waits for producers to leave before it touches the rings
+    g_dump.producers.fetch_add(1);
+    if (g_dump.active.load()) {
+        EyeFifo& fifo = g_dump.eyes[isLeft ? 0 : 1];
+        const uint64_t head = fifo.head.load(std::memory_order_relaxed);
+        if (head - fifo.tail.load(std::memory_order_acquire) >= kDumpSlotsPerEye) {
+            g_dump.dropped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            DumpSlot& slot = fifo.slots[head % kDumpSlotsPerEye];
+            const uint32_t dataSize = static_cast<uint32_t>(frame.width) * frame.height * 3 / 2;
+            if (slot.data.size() < dataSize) {
+                slot.data.resize(dataSize);
+            }
+            packNv12(frame, slot.data.data());
+            slot.header = DumpFrameHeader{kDumpFrameMagic, isLeft ? 0u : 1u, frame.width,
+                                          frame.height, dataSize, 0, frame.timestamp,
+                                          frame.sequence};
+            fifo.head.store(head + 1, std::memory_order_release);
+            g_dump.wake.notify_one();
+        }
+    }
+    g_dump.producers.fetch_sub(1);
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_StartDump(const char* path) {
+    std::lock_guard<std::mutex> lock(g_dumpControlMutex);
+    if (!path || g_dump.active.load()) {
+        LOGE("Cannot start dump: %s", path ? "already dumping" : "no path");
+        return false;
+    }
+    const int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("Cannot open dump file %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    g_dump.fd = fd;
+    g_dump.headerWritten = false;
+    g_dump.failed = false;
+    g_dump.stopping.store(false);
+    g_dump.written.store(0);
+    g_dump.dropped.store(0);
+    for (EyeFifo& fifo : g_dump.eyes) {
+        fifo.head.store(0);
+        fifo.tail.store(0);
+    }
+    g_dump.thread = std::thread(writerLoop, &g_dump);
+    g_dump.active.store(true);
+    LOGD("Dumping frames to %s", path);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT uint64_t QuestCamera_StopDump(void) {
+    std::lock_guard<std::mutex> lock(g_dumpControlMutex);
+    if (!g_dump.active.load()) {
+        return 0;
+    }
+    g_dump.active.store(false);
+    while (g_dump.producers.load() != 0) {
+        std::this_thread::yield();
+    }
+    // Everything queued so far is still written before the thread exits
+    g_dump.stopping.store(true);
+    g_dump.wake.notify_one();
+    g_dump.thread.join();
+    close(g_dump.fd);
+    g_dump.fd = -1;
+
+    const uint64_t written = g_dump.written.load();
+    const uint64_t dropped = g_dump.dropped.load();
+    if (dropped > 0) {
+        LOGW("Dump dropped %llu frames, storage could not keep up", static_cast<unsigned long long>(dropped));
+    }
+    LOGD("Dump finished, %llu frames written", static_cast<unsigned long long>(written));
+    return written;
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_StartReplay(const char* path, bool realTime, bool loop) {
+    std::lock_guard<std::mutex> lock(g_replayControlMutex);
+    releaseReplayLocked();
+    if (!path) {
+        return false;
+    }
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Cannot open dump file %s: %s", path, strerror(errno));
+        return false;
+    }
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(DumpFileHeader))) {
+        map = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);  // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        LOGE("Cannot map dump file %s", path);
+        return false;
+    }
+    g_replay.map = static_cast<const uint8_t*>(map);
+    g_replay.mapSize = static_cast<size_t>(info.st_size);
+    madvise(map, g_replay.mapSize, MADV_SEQUENTIAL);
+
+    DumpFileHeader header;
+    memcpy(&header, g_replay.map, sizeof(header));
+    if (header.magic != kDumpMagic || header.version != kDumpVersion ||
+        header.headerSize < sizeof(DumpFileHeader) || header.frameHeaderSize != sizeof(DumpFrameHeader)) {
+        LOGE("%s is not a version %u frame dump", path, kDumpVersion);
+        releaseReplayLocked();
+        return false;
+    }
+    if (!indexFrames(g_replay, header)) {
+        LOGE("%s has no frames", path);
+        releaseReplayLocked();
+        return false;
+    }
+
+    // The recorded calibration replaces the live one, as if these cameras had opened
+    for (int eye = 0; eye < 2; ++eye) {
+        if (header.calibrationVersions[eye] == 0) {
+            continue;
+        }
+        CameraCalibration calibration;
+        memcpy(calibration.intrinsics, header.calibration[eye].intrinsics, sizeof(calibration.intrinsics));
+        memcpy(calibration.distortion, header.calibration[eye].distortion, sizeof(calibration.distortion));
+        memcpy(calibration.pose, header.calibration[eye].pose, sizeof(calibration.pose));
+        publishCalibration(eye == 0, calibration);
+    }
+
+    g_replay.realTime = realTime;
+    g_replay.loop = loop;
+    g_replay.running.store(true);
+    g_replay.thread = std::thread(replayLoop, &g_replay);
+    LOGD("Replaying %zu frames from %s (%s%s)", g_replay.frameOffsets.size(), path,
+         realTime ? "original rate" : "maximum rate", loop ? ", looping" : "");
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_StopReplay(void) {
+    std::lock_guard<std::mutex> lock(g_replayControlMutex);
+    releaseReplayLocked();
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_IsReplaying(void) {
+    return g_replay.running.load();
+}
@@ -0,0 +1,70 @@
+/*
+ * Quest Camera Plugin for Unity - Raw frame dump and replay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Dump file layout, little-endian:
+//   DumpFileHeader
+//   per frame: DumpFrameHeader, dataSize bytes of packed NV12, zero padding to 8 bytes
+// Frames of both eyes are interleaved, close to timestamp order.
+constexpr uint32_t kDumpMagic = 0x50444351;       // "QCDP"
+constexpr uint32_t kDumpFrameMagic = 0x52464351;  // "QCFR"
+constexpr uint32_t kDumpVersion = 1;
+
+struct DumpCalibration {
+    float intrinsics[kIntrinsicsSize];
+    float distortion[kDistortionSize];
+    float pose[kPoseSize];
+};
+
+struct DumpFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;       // sizeof(DumpFileHeader), frames start here
+    uint32_t frameHeaderSize;  // sizeof(DumpFrameHeader)
+    int32_t width;             // Of the first frame, every frame carries its own size
+    int32_t height;
+    uint32_t calibrationVersions[2];  // Left, right; 0 = no calibration was published
+    DumpCalibration calibration[2];
+};
+
+struct DumpFrameHeader {
+    uint32_t magic;
+    uint32_t eye;  // 0 = left, 1 = right
+    int32_t width;
+    int32_t height;
+    uint32_t dataSize;
+    uint32_t reserved;
+    int64_t timestampNs;  // As the frame callbacks got it, in the domain selected while dumping
+    uint64_t sequence;
+};
+
+static_assert(sizeof(DumpFileHeader) == 176, "Dump header layout changed");
+static_assert(sizeof(DumpFrameHeader) == 40, "Dump frame header layout changed");
+
+// One relaxed load, for the frame paths to skip dumpFrame entirely
+bool isDumpActive();
+
+// Copies the frame into the dump's preallocated ring; a background thread writes it out.
+// Called from both capture paths next to the individual callbacks. Drops the frame when
+// the writer is behind instead of blocking the camera.
+void dumpFrame(bool isLeft, const FrameView& frame);
+
+} // namespace questcamera
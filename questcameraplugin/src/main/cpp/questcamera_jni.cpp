@@ -14,75 +14,294 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "QuestCameraJNI"
+
 #include <jni.h>
-#include <android/log.h>
+#include <android/native_window_jni.h>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <atomic>
+#include "questcamera_common.h"
+#include "questcamera_api.h"
+#include "questcamera_capture.h"
+#include "questcamera_combiner.h"
+#include "questcamera_convert.h"
+#include "questcamera_dump.h"
+#include "questcamera_metadata.h"
+#include "questcamera_pool.h"
+#include "questcamera_pyramid.h"
+#include "questcamera_queue.h"
+#include "questcamera_quiesce.h"
+#include "questcamera_recorder.h"
+#include "questcamera_rectify.h"
+#include "questcamera_stats.h"
+#include "questcamera_subscribers.h"
+#include "questcamera_thread.h"
+#include "questcamera_workers.h"
 
-#define LOG_TAG "QuestCameraJNI"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-// Unity callback function pointers
-typedef void (*FrameCallback)(const uint8_t* frameData, int32_t dataSize, 
-                             int32_t width, int32_t height, int64_t timestamp,
-                             const float* intrinsics, const float* distortion, 
-                             const float* pose, bool isLeft);
-typedef void (*ErrorCallback)(const char* errorMessage);
-
-// NEW: Stereo frame callback
-typedef void (*StereoFrameCallback)(const uint8_t* frameData, int32_t dataSize,
-                                   int32_t width, int32_t height, int64_t timestamp,
-                                   const float* stereoMetadata, int32_t metadataSize);
-
-static FrameCallback g_leftFrameCallback = nullptr;
-static FrameCallback g_rightFrameCallback = nullptr;
-static ErrorCallback g_errorCallback = nullptr;
-static StereoFrameCallback g_stereoFrameCallback = nullptr; // NEW
+std::atomic<FrameCallback> g_leftFrameCallback{nullptr};
+std::atomic<FrameCallback> g_rightFrameCallback{nullptr};
+std::atomic<ErrorCallback> g_errorCallback{nullptr};
+std::atomic<StereoFrameCallback> g_stereoFrameCallback{nullptr};
+std::atomic<FrameHandleCallback> g_frameHandleCallback{nullptr};
+std::atomic<HardwareBufferCallback> g_hardwareBufferCallback{nullptr};
+std::atomic<StridedFrameCallback> g_stridedFrameCallback{nullptr};
+std::atomic<LumaOutputCallback> g_lumaOutputCallback{nullptr};
+std::atomic<RectifiedFrameCallback> g_rectifiedFrameCallback{nullptr};
+std::atomic<CompactFrameCallback> g_compactFrameCallback{nullptr};
+std::atomic<CompactStereoFrameCallback> g_compactStereoFrameCallback{nullptr};
+std::atomic<StartupCallback> g_startupCallback{nullptr};
 static JavaVM* g_jvm = nullptr;
 
-// Helper function to get plugin instance
-static jobject getPluginInstance(JNIEnv* env) {
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
+// JNI classes and method IDs, resolved once in JNI_OnLoad. Class refs are global
+// so they stay valid across calls and threads.
+struct JniRegistry {
+    jclass pluginClass = nullptr;
+    jclass contextClass = nullptr;
+    jmethodID getInstance = nullptr;
+    jmethodID initialize = nullptr;
+    jmethodID startDualCamera = nullptr;
+    jmethodID stopDualCamera = nullptr;
+    jmethodID startSingleCamera = nullptr;
+    jmethodID stopSingleCamera = nullptr;
+    jmethodID configure = nullptr;
+    jmethodID pauseCapture = nullptr;
+    jmethodID resumeCapture = nullptr;
+    bool ready = false;  // All of the above resolved
+    std::atomic<jobject> instance{nullptr};  // Global ref to the singleton, resolved on first use
+};
+
+static JniRegistry g_jni;
+
+static jclass findGlobalClass(JNIEnv* env, const char* name) {
+    jclass localClass = env->FindClass(name);
+    if (!localClass) {
+        LOGE("Failed to find class %s", name);
+        env->ExceptionClear();
         return nullptr;
     }
+    auto globalClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+    env->DeleteLocalRef(localClass);
+    return globalClass;
+}
+
+static jmethodID findMethod(JNIEnv* env, jclass clazz, const char* name, const char* signature) {
+    jmethodID method = env->GetMethodID(clazz, name, signature);
+    if (!method) {
+        LOGE("Failed to find %s method", name);
+        env->ExceptionClear();
+    }
+    return method;
+}
+
+static bool initJniRegistry(JNIEnv* env) {
+    g_jni.pluginClass = findGlobalClass(env, "com/meta/questcamera/plugin/QuestCameraPlugin");
+    g_jni.contextClass = findGlobalClass(env, "android/content/Context");
+    if (!g_jni.pluginClass || !g_jni.contextClass) {
+        return false;
+    }
     
-    // Get companion object
-    jclass companionClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin$Companion");
-    if (!companionClass) {
-        LOGE("Failed to find Companion class");
-        return nullptr;
+    // @JvmStatic on the companion also emits a static getInstance on the outer class
+    g_jni.getInstance = env->GetStaticMethodID(g_jni.pluginClass, "getInstance",
+                                               "()Lcom/meta/questcamera/plugin/QuestCameraPlugin;");
+    if (!g_jni.getInstance) {
+        LOGE("Failed to find getInstance method");
+        env->ExceptionClear();
     }
     
-    jfieldID companionField = env->GetStaticFieldID(pluginClass, "Companion", "Lcom/meta/questcamera/plugin/QuestCameraPlugin$Companion;");
-    if (!companionField) {
-        LOGE("Failed to find Companion field");
+    g_jni.initialize = findMethod(env, g_jni.pluginClass, "initialize", "(Landroid/content/Context;)Z");
+    g_jni.startDualCamera = findMethod(env, g_jni.pluginClass, "startDualCamera", "()Z");
+    g_jni.stopDualCamera = findMethod(env, g_jni.pluginClass, "stopDualCamera", "()V");
+    g_jni.startSingleCamera = findMethod(env, g_jni.pluginClass, "startSingleCamera", "(Z)Z");
+    g_jni.stopSingleCamera = findMethod(env, g_jni.pluginClass, "stopSingleCamera", "(Z)V");
+    g_jni.configure = findMethod(env, g_jni.pluginClass, "configure", "(IIII)Z");
+    g_jni.pauseCapture = findMethod(env, g_jni.pluginClass, "pauseCapture", "(I)Z");
+    g_jni.resumeCapture = findMethod(env, g_jni.pluginClass, "resumeCapture", "()Z");
+    
+    g_jni.ready = g_jni.getInstance && g_jni.initialize && g_jni.startDualCamera &&
+                  g_jni.stopDualCamera && g_jni.startSingleCamera && g_jni.stopSingleCamera &&
+                  g_jni.configure && g_jni.pauseCapture && g_jni.resumeCapture;
+    return g_jni.ready;
+}
+
+static void releaseJniRegistry(JNIEnv* env) {
+    if (jobject instance = g_jni.instance.exchange(nullptr)) {
+        env->DeleteGlobalRef(instance);
+    }
+    if (g_jni.pluginClass) {
+        env->DeleteGlobalRef(g_jni.pluginClass);
+    }
+    if (g_jni.contextClass) {
+        env->DeleteGlobalRef(g_jni.contextClass);
+    }
+    g_jni.pluginClass = nullptr;
+    g_jni.contextClass = nullptr;
+    g_jni.ready = false;
+}
+
+// For C exports called from Unity threads; those are attached for the app's lifetime already
+static JNIEnv* getThreadEnv() {
+    if (!g_jvm) {
         return nullptr;
     }
-    
-    jobject companion = env->GetStaticObjectField(pluginClass, companionField);
-    if (!companion) {
-        LOGE("Failed to get Companion object");
+    JNIEnv* env = nullptr;
+    jint result = g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
+    if (result == JNI_EDETACHED && g_jvm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+        LOGE("Failed to attach thread to the JVM");
         return nullptr;
     }
+    return env;
+}
+
+// Helper function to get plugin instance. The singleton never changes, so it is
+// created on first use (not in JNI_OnLoad, which runs inside the companion's
+// static initializer) and kept as a global ref.
+static jobject getPluginInstance(JNIEnv* env) {
+    jobject instance = g_jni.instance.load(std::memory_order_acquire);
+    if (instance) {
+        return instance;
+    }
     
-    // Get getInstance method from companion
-    jmethodID getInstanceMethod = env->GetMethodID(companionClass, "getInstance", "()Lcom/meta/questcamera/plugin/QuestCameraPlugin;");
-    if (!getInstanceMethod) {
-        LOGE("Failed to find getInstance method");
+    if (!g_jni.ready) {
+        LOGE("JNI registry not initialized");
         return nullptr;
     }
     
-    // Get the plugin instance
-    jobject instance = env->CallObjectMethod(companion, getInstanceMethod);
-    if (!instance) {
+    jobject localInstance = env->CallStaticObjectMethod(g_jni.pluginClass, g_jni.getInstance);
+    if (!localInstance) {
         LOGE("Failed to get plugin instance");
+        env->ExceptionClear();
         return nullptr;
     }
     
-    return instance;
+    jobject globalInstance = env->NewGlobalRef(localInstance);
+    env->DeleteLocalRef(localInstance);
+    
+    // Another thread may have won the race; keep its ref and drop ours
+    jobject expected = nullptr;
+    if (!g_jni.instance.compare_exchange_strong(expected, globalInstance, std::memory_order_acq_rel)) {
+        env->DeleteGlobalRef(globalInstance);
+        return expected;
+    }
+    return globalInstance;
+}
+
+// Frames from processImage are tightly packed NV12
+static questcamera::FrameView packedFrameView(const uint8_t* frameBytes, jint width, jint height,
+                                              jlong timestamp) {
+    questcamera::FrameView view;
+    view.yData = frameBytes;
+    view.uvData = view.yData + width * height;
+    view.yRowStride = width;
+    view.uvRowStride = width;
+    view.width = width;
+    view.height = height;
+    view.timestamp = timestamp;
+    return view;
+}
+
+static void onJavaFrame(JNIEnv* env, bool isLeft, jobject frameBuffer, jint width, jint height,
+                        jlong timestamp) {
+    questcamera::FrameScope scope;
+    questcamera::applyEyeThreadConfigIfChanged(isLeft);
+    questcamera::TraceSection frameSection(isLeft ? "QuestCamera left frame" : "QuestCamera right frame");
+    const uint64_t sequence = questcamera::nextFrameSequence(isLeft);
+    
+    FrameCallback callback = isLeft ? g_leftFrameCallback.load() : g_rightFrameCallback.load();
+    CompactFrameCallback compactCallback = g_compactFrameCallback.load();
+    StridedFrameCallback stridedCallback = g_stridedFrameCallback.load();
+    if (callback == nullptr && compactCallback == nullptr && stridedCallback == nullptr &&
+        g_lumaOutputCallback.load() == nullptr && g_rectifiedFrameCallback.load() == nullptr &&
+        !questcamera::isFrameQueueEnabled() &&
+        !questcamera::isDumpActive() && !questcamera::hasSubscribers()) {
+        return;
+    }
+    
+    // Direct staging buffer from the native pool, read in place
+    auto* frameBytes = static_cast<const uint8_t*>(env->GetDirectBufferAddress(frameBuffer));
+    if (!frameBytes) {
+        LOGE_THROTTLED(1000, "%s frame buffer is not a direct buffer", isLeft ? "Left" : "Right");
+        return;
+    }
+    
+    // Published by nativeSetCalibration when the camera opened
+    questcamera::CameraCalibration calibration;
+    questcamera::readCalibration(isLeft, &calibration);
+    questcamera::FrameView view = packedFrameView(frameBytes, width, height, timestamp);
+    view.sequence = sequence;
+    
+    if (questcamera::isFrameQueueEnabled()) {
+        questcamera::enqueueFrame(isLeft, view, calibration);
+    }
+    questcamera::dumpFrame(isLeft, view);
+    questcamera::publishEyeFrame(isLeft, view);
+    
+    if (stridedCallback) {
+        questcamera::invokeCallback("QuestCamera strided callback", stridedCallback,
+                                    view.yData, view.uvData, view.uvData + 1, width, width, 2,
+                                    width, height, timestamp, calibration.intrinsics,
+                                    calibration.distortion, calibration.pose, isLeft);
+    }
+    questcamera::emitLumaOutputs(isLeft, view);
+    questcamera::emitRectifiedFrame(isLeft, view);
+    
+    if (callback || compactCallback) {
+        // Converted here if Unity asked for another format than NV12
+        const uint8_t* frameData = frameBytes;
+        int32_t dataSize = width * height * 3 / 2;
+        const questcamera::OutputFormat format = questcamera::outputFormat();
+        if (format != questcamera::OutputFormat::Nv12) {
+            questcamera::TraceSection section("QuestCamera pack");
+            frameData = questcamera::convertFrame(view, format, &dataSize);
+        }
+        if (callback) {
+            questcamera::invokeCallback("QuestCamera frame callback", callback, frameData, dataSize,
+                                        width, height, timestamp, calibration.intrinsics,
+                                        calibration.distortion, calibration.pose, isLeft);
+        }
+        if (compactCallback) {
+            questcamera::invokeCallback("QuestCamera frame callback", compactCallback, frameData,
+                                        dataSize, width, height, sequence, timestamp, isLeft);
+        }
+    }
+}
+
+// Frames already running may still hold the old pointer, so wait them out before returning
+template <typename Callback>
+static void setCallback(std::atomic<Callback>& slot, Callback callback) {
+    if (slot.exchange(callback) != callback) {
+        questcamera::waitForFrameQuiescence();
+    }
+}
+
+// Shared by the Kotlin natives and the C exports, Unity may use either
+static bool pauseCapture(JNIEnv* env, jint standbyFps) {
+    LOGD("Pause capture called (standby: %d fps)", standbyFps);
+    jobject pluginInstance = getPluginInstance(env);
+    if (!pluginInstance) {
+        return false;
+    }
+    jboolean result = env->CallBooleanMethod(pluginInstance, g_jni.pauseCapture, standbyFps);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    return result;
+}
+
+static bool resumeCapture(JNIEnv* env) {
+    LOGD("Resume capture called");
+    jobject pluginInstance = getPluginInstance(env);
+    if (!pluginInstance) {
+        return false;
+    }
+    jboolean result = env->CallBooleanMethod(pluginInstance, g_jni.resumeCapture);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    return result;
 }
 
 extern "C" {
@@ -91,26 +310,81 @@ extern "C" {
 JNIEXPORT void JNICALL
 Java_com_meta_questcamera_plugin_QuestCameraPlugin_setLeftFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
     LOGD("Setting left frame callback: %p", (void*)callback);
-    g_leftFrameCallback = reinterpret_cast<FrameCallback>(callback);
+    setCallback(g_leftFrameCallback, reinterpret_cast<FrameCallback>(callback));
 }
 
 JNIEXPORT void JNICALL
 Java_com_meta_questcamera_plugin_QuestCameraPlugin_setRightFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
     LOGD("Setting right frame callback: %p", (void*)callback);
-    g_rightFrameCallback = reinterpret_cast<FrameCallback>(callback);
+    setCallback(g_rightFrameCallback, reinterpret_cast<FrameCallback>(callback));
 }
 
 JNIEXPORT void JNICALL
 Java_com_meta_questcamera_plugin_QuestCameraPlugin_setErrorCallback(JNIEnv *env, jclass clazz, jlong callback) {
     LOGD("Setting error callback: %p", (void*)callback);
-    g_errorCallback = reinterpret_cast<ErrorCallback>(callback);
+    setCallback(g_errorCallback, reinterpret_cast<ErrorCallback>(callback));
 }
 
 // NEW: Stereo frame callback setter
 JNIEXPORT void JNICALL
 Java_com_meta_questcamera_plugin_QuestCameraPlugin_setStereoFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
     LOGD("Setting stereo frame callback: %p", (void*)callback);
-    g_stereoFrameCallback = reinterpret_cast<StereoFrameCallback>(callback);
+    setCallback(g_stereoFrameCallback, reinterpret_cast<StereoFrameCallback>(callback));
+}
+
+// Zero-copy frame callback setter (native capture only)
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setFrameHandleCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting frame handle callback: %p", (void*)callback);
+    setCallback(g_frameHandleCallback, reinterpret_cast<FrameHandleCallback>(callback));
+}
+
+// Plane callback setter, frames keep the camera's row and pixel strides
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setStridedFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting strided frame callback: %p", (void*)callback);
+    setCallback(g_stridedFrameCallback, reinterpret_cast<StridedFrameCallback>(callback));
+}
+
+// Pyramid level and ROI crop callback setter
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setLumaOutputCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting luma output callback: %p", (void*)callback);
+    setCallback(g_lumaOutputCallback, reinterpret_cast<LumaOutputCallback>(callback));
+}
+
+// Undistorted / rectified frame callback setter
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setRectifiedFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting rectified frame callback: %p", (void*)callback);
+    setCallback(g_rectifiedFrameCallback, reinterpret_cast<RectifiedFrameCallback>(callback));
+}
+
+// GPU frame callback setter (native capture with hardware buffer output)
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setHardwareBufferCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting hardware buffer callback: %p", (void*)callback);
+    setCallback(g_hardwareBufferCallback, reinterpret_cast<HardwareBufferCallback>(callback));
+}
+
+// Compact callback setters, calibration comes from QuestCamera_GetCalibration instead
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setCompactFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting compact frame callback: %p", (void*)callback);
+    setCallback(g_compactFrameCallback, reinterpret_cast<CompactFrameCallback>(callback));
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setCompactStereoFrameCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting compact stereo frame callback: %p", (void*)callback);
+    setCallback(g_compactStereoFrameCallback, reinterpret_cast<CompactStereoFrameCallback>(callback));
+}
+
+// First-frame (or failure) notification of a camera start
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_setStartupCallback(JNIEnv *env, jclass clazz, jlong callback) {
+    LOGD("Setting startup callback: %p", (void*)callback);
+    setCallback(g_startupCallback, reinterpret_cast<StartupCallback>(callback));
 }
 
 // Unity calls these for camera control
@@ -123,32 +397,13 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeInitialize(JNIEnv *env,
         return JNI_FALSE;
     }
     
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
-        return JNI_FALSE;
-    }
-    
-    // Call initialize on the instance
-    jmethodID initMethod = env->GetMethodID(pluginClass, "initialize", "(Landroid/content/Context;)Z");
-    if (!initMethod) {
-        LOGE("Failed to find initialize method");
-        return JNI_FALSE;
-    }
-    
     // Verify that context is indeed a Context
-    jclass contextClass = env->FindClass("android/content/Context");
-    if (!contextClass) {
-        LOGE("Failed to find Context class");
-        return JNI_FALSE;
-    }
-    
-    if (!env->IsInstanceOf(context, contextClass)) {
+    if (!env->IsInstanceOf(context, g_jni.contextClass)) {
         LOGE("Provided object is not a Context instance");
         return JNI_FALSE;
     }
     
-    jboolean result = env->CallBooleanMethod(instance, initMethod, context);
+    jboolean result = env->CallBooleanMethod(instance, g_jni.initialize, context);
     if (env->ExceptionCheck()) {
         LOGE("Exception occurred while calling initialize method");
         env->ExceptionDescribe();
@@ -169,20 +424,8 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStartDualCamera(JNIEnv
         return JNI_FALSE;
     }
     
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
-        return JNI_FALSE;
-    }
-    
     // Call startDualCamera method
-    jmethodID startMethod = env->GetMethodID(pluginClass, "startDualCamera", "()Z");
-    if (!startMethod) {
-        LOGE("Failed to find startDualCamera method");
-        return JNI_FALSE;
-    }
-    
-    jboolean result = env->CallBooleanMethod(pluginInstance, startMethod);
+    jboolean result = env->CallBooleanMethod(pluginInstance, g_jni.startDualCamera);
     LOGD("Start dual camera result: %d", result);
     return result;
 }
@@ -196,20 +439,8 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStopDualCamera(JNIEnv *
         return;
     }
     
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
-        return;
-    }
-    
     // Call stopDualCamera method
-    jmethodID stopMethod = env->GetMethodID(pluginClass, "stopDualCamera", "()V");
-    if (!stopMethod) {
-        LOGE("Failed to find stopDualCamera method");
-        return;
-    }
-    
-    env->CallVoidMethod(pluginInstance, stopMethod);
+    env->CallVoidMethod(pluginInstance, g_jni.stopDualCamera);
     LOGD("Stop dual camera completed");
 }
 
@@ -222,20 +453,8 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStartSingleCamera(JNIEn
         return JNI_FALSE;
     }
     
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
-        return JNI_FALSE;
-    }
-    
     // Call startSingleCamera method
-    jmethodID startMethod = env->GetMethodID(pluginClass, "startSingleCamera", "(Z)Z");
-    if (!startMethod) {
-        LOGE("Failed to find startSingleCamera method");
-        return JNI_FALSE;
-    }
-    
-    jboolean result = env->CallBooleanMethod(pluginInstance, startMethod, isLeft);
+    jboolean result = env->CallBooleanMethod(pluginInstance, g_jni.startSingleCamera, isLeft);
     LOGD("Start single camera result: %d", result);
     return result;
 }
@@ -249,149 +468,312 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStopSingleCamera(JNIEnv
         return;
     }
     
-    jclass pluginClass = env->FindClass("com/meta/questcamera/plugin/QuestCameraPlugin");
-    if (!pluginClass) {
-        LOGE("Failed to find QuestCameraPlugin class");
-        return;
-    }
-    
     // Call stopSingleCamera method with boolean parameter
-    jmethodID stopMethod = env->GetMethodID(pluginClass, "stopSingleCamera", "(Z)V");
-    if (!stopMethod) {
-        LOGE("Failed to find stopSingleCamera method");
-        return;
-    }
-    
-    env->CallVoidMethod(pluginInstance, stopMethod, isLeft);
+    env->CallVoidMethod(pluginInstance, g_jni.stopSingleCamera, isLeft);
     LOGD("Stop single camera completed");
 }
 
-// Called from Kotlin when frames are available
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativePauseCapture(JNIEnv *env, jclass clazz, jint standbyFps) {
+    return pauseCapture(env, standbyFps);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeResumeCapture(JNIEnv *env, jclass clazz) {
+    return resumeCapture(env);
+}
+
 JNIEXPORT void JNICALL
-Java_com_meta_questcamera_plugin_QuestCameraPlugin_onLeftFrameAvailable(
-    JNIEnv *env, jclass clazz, jbyteArray frameData, jint width, jint height, 
-    jlong timestamp, jfloatArray intrinsics, jfloatArray distortion, jfloatArray pose) {
-    
-    if (g_leftFrameCallback == nullptr) {
-        LOGD("Left frame callback is null, skipping frame");
-        return;
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeResetFrameGaps(JNIEnv *env, jclass clazz) {
+    questcamera::resetFrameGaps();
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetImageThreadConfig(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jlong cpuMask, jint niceValue, jint realtimePriority) {
+    LOGD("Native set image thread config called (isLeft: %d)", isLeft);
+    
+    questcamera::ThreadConfig config;
+    config.cpuMask = static_cast<uint64_t>(cpuMask);
+    config.niceValue = niceValue;
+    config.realtimePriority = realtimePriority;
+    questcamera::setEyeThreadConfig(isLeft, config);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetWorkerThreads(
+    JNIEnv *env, jclass clazz, jint count, jlong cpuMask, jint niceValue) {
+    questcamera::ThreadConfig config;
+    config.cpuMask = static_cast<uint64_t>(cpuMask);
+    config.niceValue = niceValue;
+    return questcamera::setWorkerThreads(count, config);
+}
+
+// Native capture path - the returned Surface is used as the capture session target
+JNIEXPORT jobject JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeCreateImageReader(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jint width, jint height, jint maxImages,
+    jint format, jboolean hardwareBufferOutput,
+    jfloatArray intrinsics, jfloatArray distortion, jfloatArray pose) {
+    LOGD("Native create image reader called (isLeft: %d)", isLeft);
+    
+    questcamera::NativeReaderConfig config;
+    config.isLeft = isLeft;
+    config.width = width;
+    config.height = height;
+    config.maxImages = maxImages;
+    config.format = format;
+    config.hardwareBufferOutput = hardwareBufferOutput;
+    
+    // Calibration is constant for the session, copy it once instead of per frame
+    env->GetFloatArrayRegion(intrinsics, 0,
+        std::min<jsize>(env->GetArrayLength(intrinsics), questcamera::kIntrinsicsSize),
+        config.calibration.intrinsics);
+    env->GetFloatArrayRegion(distortion, 0,
+        std::min<jsize>(env->GetArrayLength(distortion), questcamera::kDistortionSize),
+        config.calibration.distortion);
+    env->GetFloatArrayRegion(pose, 0,
+        std::min<jsize>(env->GetArrayLength(pose), questcamera::kPoseSize),
+        config.calibration.pose);
+    
+    ANativeWindow* window = nullptr;
+    if (!questcamera::createNativeReader(config, &window)) {
+        return nullptr;
     }
     
-    // Get array elements
-    jbyte* frameBytes = env->GetByteArrayElements(frameData, nullptr);
-    jfloat* intrinsicsFloat = env->GetFloatArrayElements(intrinsics, nullptr);
-    jfloat* distortionFloat = env->GetFloatArrayElements(distortion, nullptr);
-    jfloat* poseFloat = env->GetFloatArrayElements(pose, nullptr);
-    
-    if (!frameBytes || !intrinsicsFloat || !distortionFloat || !poseFloat) {
-        LOGE("Failed to get array elements for left frame");
-        return;
+    jobject surface = ANativeWindow_toSurface(env, window);
+    if (!surface) {
+        LOGE("Failed to wrap native reader window in a Surface");
+        questcamera::destroyNativeReader(isLeft);
     }
-    
-    jsize dataSize = env->GetArrayLength(frameData);
-    
-    LOGD("Calling left frame callback with %d bytes", dataSize);
-    
-    // Call Unity left callback
-    g_leftFrameCallback(
-        reinterpret_cast<const uint8_t*>(frameBytes), 
-        dataSize, width, height, timestamp,
-        intrinsicsFloat, distortionFloat, poseFloat, true
-    );
-    
-    // Release array elements
-    env->ReleaseByteArrayElements(frameData, frameBytes, JNI_ABORT);
-    env->ReleaseFloatArrayElements(intrinsics, intrinsicsFloat, JNI_ABORT);
-    env->ReleaseFloatArrayElements(distortion, distortionFloat, JNI_ABORT);
-    env->ReleaseFloatArrayElements(pose, poseFloat, JNI_ABORT);
+    return surface;
 }
 
 JNIEXPORT void JNICALL
-Java_com_meta_questcamera_plugin_QuestCameraPlugin_onRightFrameAvailable(
-    JNIEnv *env, jclass clazz, jbyteArray frameData, jint width, jint height,
-    jlong timestamp, jfloatArray intrinsics, jfloatArray distortion, jfloatArray pose) {
-    
-    if (g_rightFrameCallback == nullptr) {
-        LOGD("Right frame callback is null, skipping frame");
-        return;
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeDestroyImageReader(JNIEnv *env, jclass clazz, jboolean isLeft) {
+    LOGD("Native destroy image reader called (isLeft: %d)", isLeft);
+    questcamera::destroyNativeReader(isLeft);
+}
+
+// Returns the encoder's input surface, added to the capture session next to the reader
+JNIEXPORT jobject JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStartRecording(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jstring path, jint width, jint height,
+    jint fps, jint bitrate, jboolean hevc) {
+    questcamera::RecorderConfig config;
+    config.isLeft = isLeft;
+    config.width = width;
+    config.height = height;
+    config.fps = fps;
+    config.bitrate = bitrate;
+    config.hevc = hevc;
+    
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    ANativeWindow* window = nullptr;
+    const bool started = questcamera::startRecording(config, pathChars, &window);
+    env->ReleaseStringUTFChars(path, pathChars);
+    if (!started) {
+        return nullptr;
     }
     
-    // Get array elements
-    jbyte* frameBytes = env->GetByteArrayElements(frameData, nullptr);
-    jfloat* intrinsicsFloat = env->GetFloatArrayElements(intrinsics, nullptr);
-    jfloat* distortionFloat = env->GetFloatArrayElements(distortion, nullptr);
-    jfloat* poseFloat = env->GetFloatArrayElements(pose, nullptr);
-    
-    if (!frameBytes || !intrinsicsFloat || !distortionFloat || !poseFloat) {
-        LOGE("Failed to get array elements for right frame");
-        return;
+    jobject surface = ANativeWindow_toSurface(env, window);
+    if (!surface) {
+        LOGE("Failed to wrap encoder input window in a Surface");
+        questcamera::stopRecording(isLeft);
     }
-    
-    jsize dataSize = env->GetArrayLength(frameData);
-    
-    LOGD("Calling right frame callback with %d bytes", dataSize);
-    
-    // Call Unity right callback
-    g_rightFrameCallback(
-        reinterpret_cast<const uint8_t*>(frameBytes),
-        dataSize, width, height, timestamp,
-        intrinsicsFloat, distortionFloat, poseFloat, false
-    );
-    
-    // Release array elements
-    env->ReleaseByteArrayElements(frameData, frameBytes, JNI_ABORT);
-    env->ReleaseFloatArrayElements(intrinsics, intrinsicsFloat, JNI_ABORT);
-    env->ReleaseFloatArrayElements(distortion, distortionFloat, JNI_ABORT);
-    env->ReleaseFloatArrayElements(pose, poseFloat, JNI_ABORT);
+    return surface;
 }
 
-// NEW: Called from Kotlin when stereo frame is available
 JNIEXPORT void JNICALL
-Java_com_meta_questcamera_plugin_QuestCameraPlugin_onStereoFrameAvailable(
-    JNIEnv *env, jclass clazz, jbyteArray frameData, jint width, jint height,
-    jlong timestamp, jfloatArray stereoMetadata) {
-    
-    if (g_stereoFrameCallback == nullptr) {
-        LOGD("Stereo frame callback is null, skipping frame");
-        return;
-    }
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStopRecording(JNIEnv *env, jclass clazz, jboolean isLeft) {
+    questcamera::stopRecording(isLeft);
+}
+
+// Called from Kotlin when frames are available
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_onLeftFrameAvailable(
+    JNIEnv *env, jclass clazz, jobject frameBuffer, jint width, jint height, jlong timestamp) {
+    onJavaFrame(env, true, frameBuffer, width, height, timestamp);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_onRightFrameAvailable(
+    JNIEnv *env, jclass clazz, jobject frameBuffer, jint width, jint height, jlong timestamp) {
+    onJavaFrame(env, false, frameBuffer, width, height, timestamp);
+}
+
+// Called on camera open with the calibration of the stream about to start, for both capture paths
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetCalibration(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jfloatArray intrinsics, jfloatArray distortion,
+    jfloatArray pose) {
+    questcamera::CameraCalibration calibration;
+    env->GetFloatArrayRegion(intrinsics, 0,
+        std::min<jsize>(env->GetArrayLength(intrinsics), questcamera::kIntrinsicsSize),
+        calibration.intrinsics);
+    env->GetFloatArrayRegion(distortion, 0,
+        std::min<jsize>(env->GetArrayLength(distortion), questcamera::kDistortionSize),
+        calibration.distortion);
+    env->GetFloatArrayRegion(pose, 0,
+        std::min<jsize>(env->GetArrayLength(pose), questcamera::kPoseSize),
+        calibration.pose);
+    questcamera::publishCalibration(isLeft, calibration);
+}
+
+// Called from processImage once the frame is packed, with the raw sensor timestamp and
+// SystemClock.elapsedRealtimeNanos() taken right after acquireLatestImage
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeRecordFrameTiming(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jlong sensorTimestampNs, jlong acquireTimeNs,
+    jint decimatedBefore) {
+    // The first frame reports startup from here, before the frame callbacks' own scope
+    questcamera::FrameScope scope;
+    questcamera::recordFrameAcquired(isLeft, sensorTimestampNs, acquireTimeNs,
+                                     static_cast<uint32_t>(decimatedBefore));
+    questcamera::recordStage(questcamera::Stage::AcquireToCopy,
+                             questcamera::bootTimeNs() - acquireTimeNs);
+}
+
+// Called from StereoFrameCombiner for every frame while stereo combining is active
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSubmitStereoFrame(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jobject frameBuffer, jint width, jint height,
+    jlong timestamp) {
     
-    // Get array elements
-    jbyte* frameBytes = env->GetByteArrayElements(frameData, nullptr);
-    jfloat* metadataFloat = env->GetFloatArrayElements(stereoMetadata, nullptr);
+    questcamera::FrameScope scope;
+    questcamera::applyEyeThreadConfigIfChanged(isLeft);
     
-    if (!frameBytes || !metadataFloat) {
-        LOGE("Failed to get array elements for stereo frame");
+    auto* frameBytes = static_cast<const uint8_t*>(env->GetDirectBufferAddress(frameBuffer));
+    if (!frameBytes) {
+        LOGE_THROTTLED(1000, "Stereo frame buffer is not a direct buffer");
         return;
     }
     
-    jsize dataSize = env->GetArrayLength(frameData);
-    jsize metadataSize = env->GetArrayLength(stereoMetadata);
-    
-    LOGD("Calling stereo frame callback with %d bytes, metadata size: %d", dataSize, metadataSize);
-    
-    // Call Unity stereo callback
-    g_stereoFrameCallback(
-        reinterpret_cast<const uint8_t*>(frameBytes),
-        dataSize, width, height, timestamp,
-        metadataFloat, metadataSize
-    );
-    
-    // Release array elements
-    env->ReleaseByteArrayElements(frameData, frameBytes, JNI_ABORT);
-    env->ReleaseFloatArrayElements(stereoMetadata, metadataFloat, JNI_ABORT);
+    questcamera::submitStereoFrame(isLeft, packedFrameView(frameBytes, width, height, timestamp));
+}
+
+// processImage packs each eye into one pooled buffer instead of a new ByteArray per frame.
+// Only touched from the eye's image thread, release is posted there by the Kotlin side.
+static questcamera::PooledBuffer g_stagingBuffers[2];
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeReserveBufferPool(
+    JNIEnv *env, jclass clazz, jint width, jint height) {
+    questcamera::reserveBufferPool(width, height);
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeAcquireStagingBuffer(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jint size) {
+    uint8_t* data = g_stagingBuffers[isLeft ? 0 : 1].ensure(size);
+    return env->NewDirectByteBuffer(data, size);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeReleaseStagingBuffer(
+    JNIEnv *env, jclass clazz, jboolean isLeft) {
+    g_stagingBuffers[isLeft ? 0 : 1].reset();
+}
+
+// packNv12 only bulk copies the chroma plane when it is in NV12 order, same test as
+// PlaneLayout::isSemiPlanar on the native reader path
+JNIEXPORT jboolean JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeIsUvInterleaved(
+    JNIEnv *env, jclass clazz, jobject uBuffer, jobject vBuffer) {
+    auto* u = static_cast<const uint8_t*>(env->GetDirectBufferAddress(uBuffer));
+    auto* v = static_cast<const uint8_t*>(env->GetDirectBufferAddress(vBuffer));
+    return u && v == u + 1;
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeClearStereoFrames(JNIEnv *env, jclass clazz) {
+    questcamera::clearStereoFrames();
+}
+
+// Compile-time minimum log level, so the Kotlin logs follow the same build setting
+JNIEXPORT jint JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeGetMinLogLevel(JNIEnv *env, jclass clazz) {
+    return QUESTCAMERA_MIN_LOG_LEVEL;
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetDeliveryFlags(
+    JNIEnv *env, jclass clazz, jboolean individualCallbacks, jboolean stereoCombining) {
+    LOGD("Native delivery flags: individual %d, stereo %d", individualCallbacks, stereoCombining);
+    questcamera::setDeliveryFlags(individualCallbacks, stereoCombining);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetStereoSyncTolerance(
+    JNIEnv *env, jclass clazz, jlong toleranceNs) {
+    questcamera::setStereoSyncTolerance(toleranceNs);
+}
+
+// Kept in step with the Kotlin FrameGate, the native reader path decimates on its own
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeSetFrameDecimation(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jint everyN, jlong minIntervalNs) {
+    questcamera::setFrameDecimation(isLeft, everyN, minIntervalNs);
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeCaptureNextFrame(
+    JNIEnv *env, jclass clazz, jboolean isLeft) {
+    questcamera::requestNextFrame(isLeft);
+}
+
+// Called from the CaptureCallback with the result's fields, so no Java object crosses JNI
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeRecordCaptureResult(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jlong sensorTimestamp,
+    jlong exposureTimeNs, jlong frameDurationNs, jint sensitivity, jlong rollingShutterSkewNs) {
+    questcamera::recordCaptureResult(isLeft, sensorTimestamp, exposureTimeNs,
+                                     frameDurationNs, sensitivity, rollingShutterSkewNs);
+}
+
+// processImage stamps its frames through here, so both capture paths share one domain
+JNIEXPORT jlong JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeStampFrame(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jlong sensorTimestamp) {
+    return questcamera::stampFrame(isLeft, sensorTimestamp);
+}
+
+// Camera bring-up timing, the first frames are noted by recordFrameAcquired
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeBeginStartup(
+    JNIEnv *env, jclass clazz, jint eyes) {
+    questcamera::beginStartup(static_cast<uint32_t>(eyes));
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeMarkStartupStage(
+    JNIEnv *env, jclass clazz, jboolean isLeft, jint stage) {
+    questcamera::markStartupStage(isLeft, static_cast<questcamera::StartupStage>(stage));
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeFailStartup(JNIEnv *env, jclass clazz) {
+    questcamera::FrameScope scope;
+    questcamera::failStartup();
+}
+
+JNIEXPORT void JNICALL
+Java_com_meta_questcamera_plugin_QuestCameraPlugin_nativeCancelStartup(JNIEnv *env, jclass clazz) {
+    questcamera::cancelStartup();
 }
 
 JNIEXPORT void JNICALL
 Java_com_meta_questcamera_plugin_QuestCameraPlugin_onCameraError(JNIEnv *env, jclass clazz, jstring errorMessage) {
-    if (g_errorCallback == nullptr) {
+    questcamera::FrameScope scope;
+    ErrorCallback callback = g_errorCallback.load();
+    if (callback == nullptr) {
         return;
     }
     
     const char* errorStr = env->GetStringUTFChars(errorMessage, nullptr);
     if (errorStr) {
         LOGE("Camera error: %s", errorStr);
-        g_errorCallback(errorStr);
+        callback(errorStr);
         env->ReleaseStringUTFChars(errorMessage, errorStr);
     }
 }
@@ -399,12 +781,55 @@ Java_com_meta_questcamera_plugin_QuestCameraPlugin_onCameraError(JNIEnv *env, jc
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
     LOGD("JNI_OnLoad called");
     g_jvm = vm;
+    
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        LOGE("Failed to get JNIEnv in JNI_OnLoad");
+        return JNI_ERR;
+    }
+    
+    // Control calls fail individually if this does not succeed, frame delivery still works
+    if (!initJniRegistry(env)) {
+        LOGE("Failed to resolve JNI classes and methods");
+    }
     return JNI_VERSION_1_6;
 }
 
 JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved) {
     LOGD("JNI_OnUnload called");
+    
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        releaseJniRegistry(env);
+    }
     g_jvm = nullptr;
 }
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_PauseCapture(int32_t standbyFps) {
+    JNIEnv* env = getThreadEnv();
+    return env && pauseCapture(env, standbyFps);
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_ResumeCapture(void) {
+    JNIEnv* env = getThreadEnv();
+    return env && resumeCapture(env);
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_Configure(int32_t width, int32_t height, int32_t fps, int32_t format) {
+    LOGD("Configure called: %dx%d @ %d fps, format %d", width, height, fps, format);
+    
+    JNIEnv* env = getThreadEnv();
+    jobject pluginInstance = env ? getPluginInstance(env) : nullptr;
+    if (!pluginInstance) {
+        return false;
+    }
+    
+    jboolean result = env->CallBooleanMethod(pluginInstance, g_jni.configure, width, height, fps, format);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+/*
+ * Quest Camera Plugin for Unity - Logging
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/log.h>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+// Lowest android_LogPriority that is compiled in, set by QUESTCAMERA_LOG_LEVEL in
+// CMakeLists.txt. Calls below it are removed along with their argument formatting,
+// but still type-checked. The Kotlin side reads it through nativeGetMinLogLevel.
+#ifndef QUESTCAMERA_MIN_LOG_LEVEL
+#define QUESTCAMERA_MIN_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+
+// Each translation unit defines its own LOG_TAG before including this header
+#ifndef LOG_TAG
+#define LOG_TAG "QuestCameraNative"
+#endif
+
+#define QUESTCAMERA_LOG(priority, ...)                           \
+    do {                                                         \
+        if ((priority) >= QUESTCAMERA_MIN_LOG_LEVEL) {           \
+            __android_log_print((priority), LOG_TAG, __VA_ARGS__); \
+        }                                                        \
+    } while (0)
+
+#define LOGV(...) QUESTCAMERA_LOG(ANDROID_LOG_VERBOSE, __VA_ARGS__)
+#define LOGD(...) QUESTCAMERA_LOG(ANDROID_LOG_DEBUG, __VA_ARGS__)
+#define LOGI(...) QUESTCAMERA_LOG(ANDROID_LOG_INFO, __VA_ARGS__)
+#define LOGW(...) QUESTCAMERA_LOG(ANDROID_LOG_WARN, __VA_ARGS__)
+#define LOGE(...) QUESTCAMERA_LOG(ANDROID_LOG_ERROR, __VA_ARGS__)
+
+namespace questcamera {
+
+// Lets one message per interval through and counts the rest. One instance per call
+// site (see QUESTCAMERA_LOG_THROTTLED), shared by every thread that reaches it.
+class LogThrottle {
+public:
+    // Returns true if this call may log; *suppressed is then the number of calls
+    // swallowed since the last one that did
+    bool allow(int64_t intervalMs, uint32_t* suppressed) {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const int64_t nowNs = static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+        int64_t next = nextNs_.load(std::memory_order_relaxed);
+        if (nowNs < next ||
+            !nextNs_.compare_exchange_strong(next, nowNs + intervalMs * 1'000'000,
+                                             std::memory_order_relaxed)) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::atomic<int64_t> nextNs_{0};
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+} // namespace questcamera
+
+// For conditions that can repeat on every frame. fmt must be a string literal.
+#define QUESTCAMERA_LOG_THROTTLED(priority, intervalMs, fmt, ...)                              \
+    do {                                                                                     \
+        if ((priority) >= QUESTCAMERA_MIN_LOG_LEVEL) {                                       \
+            static ::questcamera::LogThrottle throttle_;                                     \
+            uint32_t suppressed_ = 0;                                                        \
+            if (throttle_.allow((intervalMs), &suppressed_)) {                               \
+                if (suppressed_ != 0) {                                                      \
+                    __android_log_print((priority), LOG_TAG, fmt " (%u more suppressed)",    \
+                                        ##__VA_ARGS__, suppressed_);                         \
+                } else {                                                                     \
+                    __android_log_print((priority), LOG_TAG, fmt, ##__VA_ARGS__);            \
+                }                                                                            \
+            }                                                                                \
+        }                                                                                    \
+    } while (0)
+
+#define LOGD_THROTTLED(intervalMs, ...) QUESTCAMERA_LOG_THROTTLED(ANDROID_LOG_DEBUG, intervalMs, __VA_ARGS__)
+#define LOGW_THROTTLED(intervalMs, ...) QUESTCAMERA_LOG_THROTTLED(ANDROID_LOG_WARN, intervalMs, __VA_ARGS__)
+#define LOGE_THROTTLED(intervalMs, ...) QUESTCAMERA_LOG_THROTTLED(ANDROID_LOG_ERROR, intervalMs, __VA_ARGS__)
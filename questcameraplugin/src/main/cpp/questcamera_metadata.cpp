@@ -0,0 +1,236 @@
+/*
+ * Quest Camera Plugin for Unity - Calibration records and frame sequencing
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraMetadata"
+
+#include "questcamera_metadata.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+#include "questcamera_clock.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+static_assert(sizeof(QuestCameraCalibration::intrinsics) == sizeof(CameraCalibration::intrinsics) &&
+              sizeof(QuestCameraCalibration::distortion) == sizeof(CameraCalibration::distortion) &&
+              sizeof(QuestCameraCalibration::pose) == sizeof(CameraCalibration::pose),
+              "QUESTCAMERA_*_SIZE must match the native calibration layout");
+
+// The records Unity holds pointers to. They live for the whole process and are
+// rewritten in place as a seqlock: version is odd while a write is in progress.
+QuestCameraCalibration g_records[2] = {};
+uint32_t g_publishedVersions[2] = {};  // Last even version, guarded by g_writeMutex
+std::mutex g_writeMutex;
+std::atomic<uint64_t> g_frameSequences[2] = {};
+
+// Recent entries, one writer per eye. Each slot is a seqlock like the calibration
+// records, so a lookup racing a rewrite of its slot retries instead of mixing two frames.
+constexpr int kRingSlots = 16;
+
+template <typename T>
+struct SeqlockRing {
+    struct Slot {
+        std::atomic<uint32_t> version{0};  // Odd while being written, 0 until first written
+        T value = {};
+    };
+    Slot slots[kRingSlots];
+    uint32_t next = 0;  // Writer only
+
+    void push(const T& value) {
+        Slot& slot = slots[next];
+        next = (next + 1) % kRingSlots;
+        const uint32_t version = slot.version.load(std::memory_order_relaxed);
+        slot.version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.value, &value, sizeof(T));
+        slot.version.store(version + 2, std::memory_order_release);
+    }
+
+    // First written entry matching, copied out coherently
+    template <typename Match>
+    bool find(Match match, T* out) const {
+        for (const Slot& slot : slots) {
+            for (;;) {
+                const uint32_t before = slot.version.load(std::memory_order_acquire);
+                if (before & 1u) {
+                    continue;
+                }
+                T candidate;
+                memcpy(&candidate, &slot.value, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.version.load(std::memory_order_relaxed) != before) {
+                    continue;
+                }
+                if (before != 0 && match(candidate)) {
+                    *out = candidate;
+                    return true;
+                }
+                break;
+            }
+        }
+        return false;
+    }
+};
+
+// Timestamp a frame was delivered with, next to the SENSOR_TIMESTAMP it was converted from
+struct FrameStamp {
+    int64_t sensorTimestampNs;
+    int64_t timestamp;
+};
+
+// Results keep only the sensor fields; timestamp and exposureMidpointNs are filled in from
+// the frame's stamp on lookup
+SeqlockRing<QuestCameraFrameMetadata> g_captureResults[2];
+SeqlockRing<FrameStamp> g_frameStamps[2];
+
+uint32_t loadVersion(const QuestCameraCalibration& record) {
+    return __atomic_load_n(&record.version, __ATOMIC_ACQUIRE);
+}
+
+void storeVersion(QuestCameraCalibration& record, uint32_t version) {
+    __atomic_store_n(&record.version, version, __ATOMIC_RELEASE);
+}
+
+bool sameValues(const QuestCameraCalibration& record, const CameraCalibration& calibration) {
+    return memcmp(record.intrinsics, calibration.intrinsics, sizeof(record.intrinsics)) == 0 &&
+           memcmp(record.distortion, calibration.distortion, sizeof(record.distortion)) == 0 &&
+           memcmp(record.pose, calibration.pose, sizeof(record.pose)) == 0;
+}
+
+} // namespace
+
+void publishCalibration(bool isLeft, const CameraCalibration& calibration) {
+    const int eye = isLeft ? 0 : 1;
+    QuestCameraCalibration& record = g_records[eye];
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+    const uint32_t version = g_publishedVersions[eye];
+    if (version != 0 && sameValues(record, calibration)) {
+        return;
+    }
+
+    storeVersion(record, version + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(record.intrinsics, calibration.intrinsics, sizeof(record.intrinsics));
+    memcpy(record.distortion, calibration.distortion, sizeof(record.distortion));
+    memcpy(record.pose, calibration.pose, sizeof(record.pose));
+    storeVersion(record, version + 2);
+    g_publishedVersions[eye] = version + 2;
+    LOGD("%s calibration published, version %u", isLeft ? "Left" : "Right", version + 2);
+}
+
+uint32_t readCalibration(bool isLeft, CameraCalibration* out) {
+    const QuestCameraCalibration& record = g_records[isLeft ? 0 : 1];
+    for (;;) {
+        const uint32_t before = loadVersion(record);
+        if (before & 1u) {
+            continue;
+        }
+        memcpy(out->intrinsics, record.intrinsics, sizeof(out->intrinsics));
+        memcpy(out->distortion, record.distortion, sizeof(out->distortion));
+        memcpy(out->pose, record.pose, sizeof(out->pose));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (loadVersion(record) == before) {
+            return before;
+        }
+    }
+}
+
+uint32_t calibrationVersion(bool isLeft) {
+    return loadVersion(g_records[isLeft ? 0 : 1]);
+}
+
+void recordCaptureResult(bool isLeft, int64_t sensorTimestampNs, int64_t exposureTimeNs,
+                         int64_t frameDurationNs, int32_t sensitivity, int64_t rollingShutterSkewNs) {
+    QuestCameraFrameMetadata metadata = {};
+    metadata.sensorTimestampNs = sensorTimestampNs;
+    metadata.exposureTimeNs = exposureTimeNs;
+    metadata.frameDurationNs = frameDurationNs;
+    metadata.rollingShutterSkewNs = rollingShutterSkewNs;
+    metadata.sensitivity = sensitivity;
+    g_captureResults[isLeft ? 0 : 1].push(metadata);
+}
+
+bool findSensorTimestamp(bool isLeft, int64_t timeUs, int64_t* outSensorTimestampNs) {
+    QuestCameraFrameMetadata metadata;
+    if (!g_captureResults[isLeft ? 0 : 1].find(
+            [timeUs](const QuestCameraFrameMetadata& m) { return m.sensorTimestampNs / 1000 == timeUs; },
+            &metadata)) {
+        return false;
+    }
+    *outSensorTimestampNs = metadata.sensorTimestampNs;
+    return true;
+}
+
+int64_t stampFrame(bool isLeft, int64_t sensorTimestampNs) {
+    const FrameStamp stamp = {sensorTimestampNs, toFrameTime(sensorTimestampNs)};
+    g_frameStamps[isLeft ? 0 : 1].push(stamp);
+    return stamp.timestamp;
+}
+
+uint64_t nextFrameSequence(bool isLeft) {
+    return g_frameSequences[isLeft ? 0 : 1].fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT const QuestCameraCalibration* QuestCamera_GetCalibration(bool isLeft) {
+    return &g_records[isLeft ? 0 : 1];
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_GetFrameMetadata(bool isLeft, int64_t timestamp,
+                                                                QuestCameraFrameMetadata* outMetadata) {
+    if (!outMetadata) {
+        return false;
+    }
+    const int eye = isLeft ? 0 : 1;
+    // The frame's own stamp gives the sensor timestamp; converting timestamp back would
+    // miss whenever the domain offset moved since the frame was delivered
+    FrameStamp stamp;
+    if (!g_frameStamps[eye].find([timestamp](const FrameStamp& s) { return s.timestamp == timestamp; },
+                                 &stamp)) {
+        return false;
+    }
+    QuestCameraFrameMetadata metadata;
+    if (!g_captureResults[eye].find(
+            [&stamp](const QuestCameraFrameMetadata& m) { return m.sensorTimestampNs == stamp.sensorTimestampNs; },
+            &metadata)) {
+        return false;
+    }
+    metadata.timestamp = timestamp;
+    // Middle row starts half the skew after the first one
+    metadata.exposureMidpointNs = timestamp + (metadata.rollingShutterSkewNs + metadata.exposureTimeNs) / 2;
+    *outMetadata = metadata;
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_CopyCalibration(bool isLeft, QuestCameraCalibration* outCalibration) {
+    if (!outCalibration) {
+        return false;
+    }
+    CameraCalibration calibration;
+    const uint32_t version = readCalibration(isLeft, &calibration);
+    outCalibration->version = version;
+    memcpy(outCalibration->intrinsics, calibration.intrinsics, sizeof(outCalibration->intrinsics));
+    memcpy(outCalibration->distortion, calibration.distortion, sizeof(outCalibration->distortion));
+    memcpy(outCalibration->pose, calibration.pose, sizeof(outCalibration->pose));
+    return version != 0;
+}
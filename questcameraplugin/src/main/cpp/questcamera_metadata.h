@@ -0,0 +1,53 @@
+/*
+ * Quest Camera Plugin for Unity - Calibration records and frame sequencing
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Replaces one eye's calibration record, the one QuestCamera_GetCalibration points
+// at. Called when a camera opens; its version only changes when the values do.
+void publishCalibration(bool isLeft, const CameraCalibration& calibration);
+
+// Coherent copy of one eye's record, returns its version (0 = never published).
+// Lock-free, so it is cheap enough for the frame path.
+uint32_t readCalibration(bool isLeft, CameraCalibration* out);
+
+// Version only, to skip repacking derived data while it has not changed
+uint32_t calibrationVersion(bool isLeft);
+
+// Stores one capture result in the eye's ring of recent results, keyed by its raw
+// SENSOR_TIMESTAMP (boot time). Called from the eye's camera thread as each result
+// completes, lock-free for QuestCamera_GetFrameMetadata.
+void recordCaptureResult(bool isLeft, int64_t sensorTimestampNs, int64_t exposureTimeNs,
+                         int64_t frameDurationNs, int32_t sensitivity, int64_t rollingShutterSkewNs);
+
+// Full-precision SENSOR_TIMESTAMP of a recent capture result whose timestamp truncates to
+// timeUs, such as an encoder presentation time. False once the result has left the ring.
+bool findSensorTimestamp(bool isLeft, int64_t timeUs, int64_t* outSensorTimestampNs);
+
+// toFrameTime for a frame about to be delivered, remembering which SENSOR_TIMESTAMP the
+// returned timestamp came from. QuestCamera_GetFrameMetadata goes through that pair, so
+// it still finds the result after an offset refresh or a domain change. Called once per
+// frame by whichever capture path the eye runs on.
+int64_t stampFrame(bool isLeft, int64_t sensorTimestampNs);
+
+// Per-eye frame counter shared by both capture paths, starts at 0
+uint64_t nextFrameSequence(bool isLeft);
+
+} // namespace questcamera
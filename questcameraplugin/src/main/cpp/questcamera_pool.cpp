@@ -0,0 +1,166 @@
+/*
+ * Quest Camera Plugin for Unity - Shared frame buffer pool
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraPool"
+
+#include "questcamera_pool.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+// Two eyes x (staging, convert) plus three stereo slots fit with room to spare
+constexpr int kMaxSlabs = 16;
+constexpr int kReservedSlabsPerEye = 2;
+
+struct Slab {
+    std::unique_ptr<uint8_t[]> data;
+    int32_t capacity = 0;
+    bool inUse = false;
+};
+
+// Acquire/release only happen when an owner starts streaming or grows its buffer,
+// never per frame, so a mutex is enough.
+struct SlabPool {
+    std::mutex mutex;
+    Slab slabs[kMaxSlabs];
+    int32_t slabCount = 0;
+    int32_t inUse = 0;
+    int32_t peakInUse = 0;
+    int64_t poolBytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Never destroyed: thread_local owners may release into it during process teardown
+SlabPool& pool() {
+    static SlabPool* instance = new SlabPool();
+    return *instance;
+}
+
+int addSlabLocked(SlabPool& state, int32_t size) {
+    if (state.slabCount >= kMaxSlabs) {
+        return -1;
+    }
+    Slab& slab = state.slabs[state.slabCount];
+    slab.data.reset(new uint8_t[size]);
+    slab.capacity = size;
+    state.poolBytes += size;
+    return state.slabCount++;
+}
+
+// Smallest free slab that fits, so small requests do not take the stereo slabs
+int findFreeSlabLocked(const SlabPool& state, int32_t size) {
+    int best = -1;
+    for (int i = 0; i < state.slabCount; ++i) {
+        const Slab& slab = state.slabs[i];
+        if (!slab.inUse && slab.capacity >= size &&
+            (best < 0 || slab.capacity < state.slabs[best].capacity)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void markInUseLocked(SlabPool& state, int index) {
+    state.slabs[index].inUse = true;
+    state.peakInUse = std::max(state.peakInUse, ++state.inUse);
+}
+
+} // namespace
+
+uint8_t* PooledBuffer::ensure(int32_t size) {
+    if (data_ && capacity_ >= size) {
+        return data_;
+    }
+    reset();
+
+    SlabPool& state = pool();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        int index = findFreeSlabLocked(state, size);
+        if (index >= 0) {
+            ++state.hits;
+        } else {
+            // Not preallocated for this size: grow while there is room, else go to the heap
+            ++state.misses;
+            index = addSlabLocked(state, size);
+        }
+        if (index >= 0) {
+            markInUseLocked(state, index);
+            slab_ = index;
+            data_ = state.slabs[index].data.get();
+            capacity_ = state.slabs[index].capacity;
+            return data_;
+        }
+    }
+
+    LOGW_THROTTLED(1000, "Buffer pool exhausted, allocating %d bytes", size);
+    heap_.reset(new uint8_t[size]);
+    data_ = heap_.get();
+    capacity_ = size;
+    return data_;
+}
+
+void PooledBuffer::reset() {
+    if (slab_ >= 0) {
+        SlabPool& state = pool();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.slabs[slab_].inUse = false;
+        --state.inUse;
+    }
+    heap_.reset();
+    data_ = nullptr;
+    capacity_ = 0;
+    slab_ = -1;
+}
+
+void reserveBufferPool(int32_t frameWidth, int32_t frameHeight) {
+    const int32_t frameSize = frameWidth * frameHeight * 3 / 2;
+    SlabPool& state = pool();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    int fitting = 0;
+    for (int i = 0; i < state.slabCount; ++i) {
+        fitting += state.slabs[i].capacity >= frameSize ? 1 : 0;
+    }
+    // Slabs are kept once allocated; a smaller config just leaves them oversized
+    while (fitting < kReservedSlabsPerEye * 2 && addSlabLocked(state, frameSize) >= 0) {
+        ++fitting;
+    }
+    LOGD("Buffer pool reserved for %dx%d: %d slabs, %lld bytes", frameWidth, frameHeight,
+         state.slabCount, static_cast<long long>(state.poolBytes));
+}
+
+} // namespace questcamera
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_GetBufferPoolStats(QuestCameraBufferPoolStats* outStats) {
+    if (!outStats) {
+        return;
+    }
+    questcamera::SlabPool& state = questcamera::pool();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    outStats->slabCount = state.slabCount;
+    outStats->slabsInUse = state.inUse;
+    outStats->peakSlabsInUse = state.peakInUse;
+    outStats->poolBytes = state.poolBytes;
+    outStats->hits = state.hits;
+    outStats->misses = state.misses;
+}
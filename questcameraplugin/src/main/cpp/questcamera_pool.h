@@ -0,0 +1,55 @@
+/*
+ * Quest Camera Plugin for Unity - Shared frame buffer pool
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace questcamera {
+
+// Frame-sized memory taken from the process-wide slab pool. Falls back to a heap
+// allocation (counted as a pool miss) when no slab is free and the pool is full.
+// Not thread-safe itself; each owner keeps its buffer for as long as it streams.
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer() { reset(); }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    // At least size bytes. Keeps the current memory if it is large enough, so in steady
+    // state this never touches the pool.
+    uint8_t* ensure(int32_t size);
+
+    // Returns the memory to the pool
+    void reset();
+
+    uint8_t* data() const { return data_; }
+    int32_t capacity() const { return capacity_; }
+
+private:
+    uint8_t* data_ = nullptr;
+    int32_t capacity_ = 0;
+    int32_t slab_ = -1;  // -1 when empty or heap-backed
+    std::unique_ptr<uint8_t[]> heap_;
+};
+
+// Preallocates slabs for the active camera config: a staging/pack buffer per eye.
+// Larger buffers (stereo, RGBA) are added on first use, up to the pool's slab limit.
+void reserveBufferPool(int32_t frameWidth, int32_t frameHeight);
+
+} // namespace questcamera
@@ -0,0 +1,205 @@
+/*
+ * Quest Camera Plugin for Unity - Luma pyramid and ROI crops
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraPyramid"
+
+#include "questcamera_pyramid.h"
+#include "questcamera_api.h"
+#include "questcamera_stats.h"
+#include "questcamera_workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace questcamera {
+namespace {
+
+struct Roi {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+// ROIs are updated from Unity every few frames, the image thread copies them per frame
+struct RoiSet {
+    std::mutex mutex;
+    Roi rois[QUESTCAMERA_MAX_ROIS];
+    std::atomic<int32_t> count{0};  // Non-empty entries, lets frames skip the lock
+};
+
+std::atomic<int32_t> g_pyramidScale{0};
+RoiSet g_roiSets[2];
+
+thread_local std::vector<uint8_t> t_levelBuffer;
+thread_local std::vector<uint8_t> t_halfBuffer;  // First pass of the 4x level
+thread_local std::vector<uint8_t> t_cropBuffer;
+
+constexpr int32_t kRowsPerBand = 16;  // Output rows, each reads two source rows
+
+// Output rows [begin, end) of downscale2x
+void downscaleRows(const uint8_t* src, int32_t srcStride, int32_t dstWidth, uint8_t* dst,
+                   int32_t begin, int32_t end) {
+    for (int32_t row = begin; row < end; ++row) {
+        const uint8_t* top = src + (row * 2) * srcStride;
+        const uint8_t* bottom = top + srcStride;
+        uint8_t* out = dst + row * dstWidth;
+        int32_t x = 0;
+#if defined(__ARM_NEON)
+        for (; x + 16 <= dstWidth; x += 16) {
+            // Pairwise widening adds sum horizontal pairs, then the two rows are added
+            const uint8x16x2_t t = vld1q_u8_x2(top + x * 2);
+            const uint8x16x2_t b = vld1q_u8_x2(bottom + x * 2);
+            const uint16x8_t sumLow = vpadalq_u8(vpaddlq_u8(t.val[0]), b.val[0]);
+            const uint16x8_t sumHigh = vpadalq_u8(vpaddlq_u8(t.val[1]), b.val[1]);
+            vst1q_u8(out + x, vcombine_u8(vrshrn_n_u16(sumLow, 2), vrshrn_n_u16(sumHigh, 2)));
+        }
+#endif
+        for (; x < dstWidth; ++x) {
+            const int32_t sum = top[x * 2] + top[x * 2 + 1] + bottom[x * 2] + bottom[x * 2 + 1];
+            out[x] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+// Mean of each 2x2 block, rounded. Odd trailing rows and columns are dropped.
+void downscale2x(const uint8_t* src, int32_t srcStride, int32_t srcWidth, int32_t srcHeight,
+                 uint8_t* dst) {
+    const int32_t dstWidth = srcWidth / 2;
+    parallelFor(srcHeight / 2, kRowsPerBand, [&](int32_t begin, int32_t end) {
+        downscaleRows(src, srcStride, dstWidth, dst, begin, end);
+    });
+}
+
+void emitPyramid(bool isLeft, const FrameView& frame, int32_t scale, LumaOutputCallback callback) {
+    int32_t width = frame.width / 2;
+    int32_t height = frame.height / 2;
+    t_levelBuffer.resize(width * height);
+    downscale2x(frame.yData, frame.yRowStride, frame.width, frame.height, t_levelBuffer.data());
+
+    if (scale == 4) {
+        t_halfBuffer.swap(t_levelBuffer);
+        const int32_t halfWidth = width;
+        const int32_t halfHeight = height;
+        width /= 2;
+        height /= 2;
+        t_levelBuffer.resize(width * height);
+        downscale2x(t_halfBuffer.data(), halfWidth, halfWidth, halfHeight, t_levelBuffer.data());
+    }
+
+    invokeCallback("QuestCamera luma callback", callback,
+                   static_cast<const uint8_t*>(t_levelBuffer.data()), width, height,
+                   QUESTCAMERA_LUMA_PYRAMID, 0, 0, 0, scale, frame.timestamp, isLeft);
+}
+
+void emitRois(bool isLeft, const FrameView& frame, LumaOutputCallback callback) {
+    RoiSet& set = g_roiSets[isLeft ? 0 : 1];
+    Roi rois[QUESTCAMERA_MAX_ROIS];
+    {
+        std::lock_guard<std::mutex> lock(set.mutex);
+        std::copy(std::begin(set.rois), std::end(set.rois), rois);
+    }
+
+    for (int32_t index = 0; index < QUESTCAMERA_MAX_ROIS; ++index) {
+        const int32_t x = std::clamp(rois[index].x, 0, frame.width);
+        const int32_t y = std::clamp(rois[index].y, 0, frame.height);
+        const int32_t width = std::min(rois[index].width, frame.width - x);
+        const int32_t height = std::min(rois[index].height, frame.height - y);
+        if (width <= 0 || height <= 0) {
+            continue;
+        }
+
+        const uint8_t* src = frame.yData + y * frame.yRowStride + x;
+        const uint8_t* data = src;
+        if (frame.yRowStride != width) {
+            t_cropBuffer.resize(width * height);
+            for (int32_t row = 0; row < height; ++row) {
+                memcpy(t_cropBuffer.data() + row * width, src + row * frame.yRowStride, width);
+            }
+            data = t_cropBuffer.data();
+        }
+        invokeCallback("QuestCamera luma callback", callback, data, width, height,
+                       QUESTCAMERA_LUMA_ROI, index, x, y, 1, frame.timestamp, isLeft);
+    }
+}
+
+} // namespace
+
+void emitLumaOutputs(bool isLeft, const FrameView& frame) {
+    LumaOutputCallback callback = g_lumaOutputCallback.load();
+    if (!callback) {
+        return;
+    }
+
+    const int32_t scale = g_pyramidScale.load(std::memory_order_relaxed);
+    if (scale > 1) {
+        emitPyramid(isLeft, frame, scale, callback);
+    }
+    if (g_roiSets[isLeft ? 0 : 1].count.load(std::memory_order_relaxed) > 0) {
+        emitRois(isLeft, frame, callback);
+    }
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetPyramidScale(int32_t scale) {
+    if (scale != 0 && scale != 1 && scale != 2 && scale != 4) {
+        LOGE("Unsupported pyramid scale %d", scale);
+        return false;
+    }
+    LOGD("Setting pyramid scale: %d", scale);
+    g_pyramidScale.store(scale, std::memory_order_relaxed);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetRoi(bool isLeft, int32_t index, int32_t x, int32_t y,
+                                                      int32_t width, int32_t height) {
+    if (index < 0 || index >= QUESTCAMERA_MAX_ROIS) {
+        LOGE("ROI index %d out of range", index);
+        return false;
+    }
+
+    RoiSet& set = g_roiSets[isLeft ? 0 : 1];
+    std::lock_guard<std::mutex> lock(set.mutex);
+    Roi& roi = set.rois[index];
+    roi.x = x;
+    roi.y = y;
+    roi.width = std::max(width, 0);
+    roi.height = std::max(height, 0);
+
+    int32_t count = 0;
+    for (const Roi& entry : set.rois) {
+        count += entry.width > 0 && entry.height > 0 ? 1 : 0;
+    }
+    set.count.store(count, std::memory_order_relaxed);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_ClearRois(bool isLeft) {
+    RoiSet& set = g_roiSets[isLeft ? 0 : 1];
+    std::lock_guard<std::mutex> lock(set.mutex);
+    std::fill(std::begin(set.rois), std::end(set.rois), Roi());
+    set.count.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,27 @@
+/*
+ * Quest Camera Plugin for Unity - Luma pyramid and ROI crops
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Emits the configured pyramid level and ROI crops of the frame's luma through
+// LumaOutputCallback, on the calling image thread. No-op while nothing is configured.
+void emitLumaOutputs(bool isLeft, const FrameView& frame);
+
+} // namespace questcamera
@@ -0,0 +1,191 @@
+/*
+ * Quest Camera Plugin for Unity - Per-eye frame queues
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraQueue"
+
+#include "questcamera_queue.h"
+#include "questcamera_api.h"
+#include "questcamera_ring.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace questcamera {
+namespace {
+
+constexpr int32_t kMaxQueueSlots = 16;
+
+struct QueuedFrame {
+    std::unique_ptr<uint8_t[]> data;
+    int32_t dataSize = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    int64_t timestamp = 0;
+    uint64_t sequence = 0;
+    CameraCalibration calibration;
+};
+
+struct EyeQueue {
+    FrameRing<QueuedFrame> ring;
+    uint64_t nextSequence = 0;  // Producer only
+};
+
+struct QueueState {
+    EyeQueue eyes[2];
+    int32_t slotBytes = 0;
+    std::atomic<bool> enabled{false};
+    std::atomic<int32_t> inFlight{0};  // Producers and consumers currently inside the rings
+    std::mutex configMutex;
+};
+
+QueueState g_queues;
+
+// Keeps reconfiguration from pulling slots out from under a producer or consumer
+class InFlightScope {
+public:
+    InFlightScope() { g_queues.inFlight.fetch_add(1); }
+    ~InFlightScope() { g_queues.inFlight.fetch_sub(1); }
+};
+
+void quiesceLocked() {
+    g_queues.enabled.store(false);
+    while (g_queues.inFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+bool isFrameQueueEnabled() {
+    return g_queues.enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t queueDroppedFrames(bool isLeft) {
+    return g_queues.eyes[isLeft ? 0 : 1].ring.droppedFrames();
+}
+
+void enqueueFrame(bool isLeft, const FrameView& frame, const CameraCalibration& calibration) {
+    InFlightScope scope;
+    if (!g_queues.enabled.load()) {
+        return;
+    }
+
+    const int32_t ySize = frame.width * frame.height;
+    const int32_t frameSize = ySize + ySize / 2;
+    if (frameSize > g_queues.slotBytes) {
+        LOGW_THROTTLED(1000, "Frame %dx%d does not fit the queue slots, dropped", frame.width, frame.height);
+        return;
+    }
+
+    EyeQueue& queue = g_queues.eyes[isLeft ? 0 : 1];
+    QueuedFrame* slot = queue.ring.beginWrite();
+    const uint64_t sequence = queue.nextSequence++;
+    if (!slot) {
+        return;
+    }
+
+    uint8_t* dst = slot->data.get();
+    for (int32_t row = 0; row < frame.height; ++row) {
+        memcpy(dst + row * frame.width, frame.yData + row * frame.yRowStride, frame.width);
+    }
+    const bool semiPlanar = frame.isSemiPlanar();
+    for (int32_t row = 0; row < frame.height / 2; ++row) {
+        uint8_t* dstRow = dst + ySize + row * frame.width;
+        if (semiPlanar) {
+            memcpy(dstRow, frame.uvData + row * frame.uvRowStride, frame.width);
+        } else {
+            gatherUvRow(frame, row, dstRow);
+        }
+    }
+
+    slot->dataSize = frameSize;
+    slot->width = frame.width;
+    slot->height = frame.height;
+    slot->timestamp = frame.timestamp;
+    slot->sequence = sequence;
+    slot->calibration = calibration;
+    queue.ring.commitWrite();
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_EnableFrameQueue(int32_t slotCount, int32_t width, int32_t height) {
+    if (slotCount < 2 || slotCount > kMaxQueueSlots || width <= 0 || height <= 0) {
+        LOGE("Invalid frame queue configuration: %d slots, %dx%d", slotCount, width, height);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_queues.configMutex);
+    quiesceLocked();
+
+    const int32_t slotBytes = width * height + width * height / 2;
+    for (EyeQueue& queue : g_queues.eyes) {
+        queue.ring.reset(slotCount);
+        for (size_t i = 0; i < queue.ring.size(); ++i) {
+            queue.ring.slotAt(i).data.reset(new uint8_t[slotBytes]);
+        }
+        queue.nextSequence = 0;
+    }
+    g_queues.slotBytes = slotBytes;
+    g_queues.enabled.store(true);
+
+    LOGD("Frame queues enabled: %d slots of %dx%d per eye", slotCount, width, height);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_DisableFrameQueue(void) {
+    std::lock_guard<std::mutex> lock(g_queues.configMutex);
+    quiesceLocked();
+    for (EyeQueue& queue : g_queues.eyes) {
+        queue.ring.reset(0);
+    }
+    g_queues.slotBytes = 0;
+    LOGD("Frame queues disabled");
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_TryDequeueFrame(bool isLeft, QuestCameraFrame* outFrame) {
+    if (!outFrame) {
+        return false;
+    }
+
+    InFlightScope scope;
+    if (!g_queues.enabled.load()) {
+        return false;
+    }
+
+    auto& ring = g_queues.eyes[isLeft ? 0 : 1].ring;
+    const QueuedFrame* frame = ring.acquireLatest();
+    if (!frame) {
+        return false;
+    }
+
+    outFrame->data = frame->data.get();
+    outFrame->dataSize = frame->dataSize;
+    outFrame->width = frame->width;
+    outFrame->height = frame->height;
+    outFrame->timestamp = frame->timestamp;
+    outFrame->sequence = frame->sequence;
+    outFrame->droppedFrames = ring.droppedFrames();
+    outFrame->intrinsics = frame->calibration.intrinsics;
+    outFrame->distortion = frame->calibration.distortion;
+    outFrame->pose = frame->calibration.pose;
+    return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * Quest Camera Plugin for Unity - Per-eye frame queues
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+bool isFrameQueueEnabled();
+
+// Copies the frame into the eye's ring if queues are enabled (QuestCamera_EnableFrameQueue).
+// Never blocks: when Unity falls behind, the oldest queued frame is dropped.
+void enqueueFrame(bool isLeft, const FrameView& frame, const CameraCalibration& calibration);
+
+// Frames one eye's ring dropped since the queues were last enabled
+uint64_t queueDroppedFrames(bool isLeft);
+
+} // namespace questcamera
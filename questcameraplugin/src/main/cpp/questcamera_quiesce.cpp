@@ -0,0 +1,147 @@
+/*
+ * Quest Camera Plugin for Unity - Quiescent-state tracking for the frame threads
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraQuiesce"
+
+#include "questcamera_quiesce.h"
+#include "questcamera_api.h"
+
+#include <atomic>
+#include <thread>
+
+namespace questcamera {
+namespace {
+
+// Eye threads of both capture paths, the replay thread and whatever reports errors.
+// Readers are recreated per camera start, so slots are returned when a thread exits.
+constexpr int kMaxFrameThreads = 32;
+
+struct ThreadSlot {
+    std::atomic<uint64_t> sequence{0};  // Odd while the owning thread is inside a frame
+    std::atomic<bool> claimed{false};
+    // Set while the owner waits for quiescence from inside its frame. Two such waiters
+    // would wait on each other forever, so they skip each other's slot.
+    std::atomic<bool> waitingInFrame{false};
+};
+
+ThreadSlot g_slots[kMaxFrameThreads];
+std::atomic<int> g_slotsUsed{0};          // High-water mark, the waiter scans no further
+std::atomic<int> g_unslottedFrames{0};    // Frames of threads that found every slot taken
+
+struct ThreadRegistration {
+    ThreadSlot* slot = nullptr;
+    bool slotless = false;
+    int depth = 0;
+
+    ~ThreadRegistration() {
+        if (slot) {
+            slot->claimed.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRegistration t_registration;
+
+ThreadSlot* claimSlot() {
+    for (int index = 0; index < kMaxFrameThreads; ++index) {
+        bool expected = false;
+        if (g_slots[index].claimed.compare_exchange_strong(expected, true)) {
+            int used = g_slotsUsed.load();
+            while (used <= index && !g_slotsUsed.compare_exchange_weak(used, index + 1)) {
+            }
+            return &g_slots[index];
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+FrameScope::FrameScope() {
+    ThreadRegistration& registration = t_registration;
+    if (registration.depth++ > 0) {
+        return;
+    }
+    if (!registration.slot && !registration.slotless) {
+        registration.slot = claimSlot();
+        if (!registration.slot) {
+            LOGW("More than %d frame threads, quiescence falls back to a shared counter", kMaxFrameThreads);
+            registration.slotless = true;
+        }
+    }
+    // Sequentially consistent, so a frame either is seen here by the waiter or sees its stores
+    if (registration.slot) {
+        registration.slot->sequence.fetch_add(1);
+    } else {
+        g_unslottedFrames.fetch_add(1);
+    }
+}
+
+FrameScope::~FrameScope() {
+    ThreadRegistration& registration = t_registration;
+    if (--registration.depth > 0) {
+        return;
+    }
+    if (registration.slot) {
+        registration.slot->sequence.fetch_add(1, std::memory_order_release);
+    } else {
+        g_unslottedFrames.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void waitForFrameQuiescence() {
+    // From inside a frame (e.g. a Unity callback changing callbacks) that frame cannot finish
+    // while it waits, so only the other threads' frames are waited for
+    ThreadSlot* const ownSlot = t_registration.depth > 0 ? t_registration.slot : nullptr;
+    const bool inFrame = t_registration.depth > 0;
+    if (ownSlot) {
+        ownSlot->waitingInFrame.store(true);
+    }
+    const int used = g_slotsUsed.load();
+    uint64_t snapshot[kMaxFrameThreads];
+    for (int index = 0; index < used; ++index) {
+        snapshot[index] = g_slots[index].sequence.load();
+    }
+    // Any change means the frame seen running has finished, the next one already reads new state
+    for (int index = 0; index < used; ++index) {
+        ThreadSlot& slot = g_slots[index];
+        if ((snapshot[index] & 1) == 0 || &slot == ownSlot) {
+            continue;
+        }
+        while (slot.sequence.load(std::memory_order_acquire) == snapshot[index] &&
+               !(inFrame && slot.waitingInFrame.load())) {
+            std::this_thread::yield();
+        }
+    }
+    if (ownSlot) {
+        ownSlot->waitingInFrame.store(false);
+    }
+    // A slotless caller inside a frame is itself counted here and cannot be told apart
+    // from the others, so it does not wait on the shared counter
+    if (!(inFrame && !ownSlot)) {
+        while (g_unslottedFrames.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_WaitForFrameQuiescence() {
+    waitForFrameQuiescence();
+}
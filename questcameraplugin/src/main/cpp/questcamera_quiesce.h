@@ -0,0 +1,42 @@
+/*
+ * Quest Camera Plugin for Unity - Quiescent-state tracking for the frame threads
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Marks the calling thread as running a frame for the scope's lifetime. Every entry
+// point that can reach a Unity callback opens one: both capture paths, replay and the
+// error callback. Costs two atomic increments on a slot of the thread's own, scopes nest.
+class FrameScope {
+public:
+    FrameScope();
+    ~FrameScope();
+    FrameScope(const FrameScope&) = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+};
+
+// Returns once every frame that was running when it was called has left its FrameScope.
+// Frames that start later see whatever the caller stored before, so after swapping a
+// callback pointer and waiting, the old callback is no longer running. Never blocks the
+// frame threads. Called from inside a frame (e.g. a Unity callback changing callbacks) it
+// skips the caller's own frame, which cannot finish while it waits, and still waits for
+// the other threads' frames, except those of threads waiting from inside a frame as well.
+void waitForFrameQuiescence();
+
+} // namespace questcamera
@@ -0,0 +1,299 @@
+/*
+ * Quest Camera Plugin for Unity - Hardware encoded recording
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraRecorder"
+
+#include "questcamera_recorder.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+#include "questcamera_metadata.h"
+
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaFormat.h>
+#include <media/NdkMediaMuxer.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace questcamera {
+namespace {
+
+constexpr int32_t kDefaultFps = 30;
+constexpr float kDefaultBitsPerPixel = 0.15f;
+constexpr int32_t kIFrameIntervalSeconds = 1;
+constexpr int32_t kColorFormatSurface = 0x7F000789;  // MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface
+constexpr int64_t kDrainTimeoutUs = 10'000;
+constexpr int kEndOfStreamWaitPolls = 100;  // ~1s of empty polls before giving up on EOS
+
+constexpr const char* kCalibrationMime = "application/x-questcamera-calibration";
+constexpr uint32_t kCalibrationSampleLayout = 2;  // 1 had the timestamp in the frame time domain
+
+// One sample per video frame on the calibration track, with the frame's presentation time:
+// the record the frame callbacks would have passed for it, little-endian.
+struct CalibrationSample {
+    uint32_t layout;
+    uint32_t calibrationVersion;  // As returned by QuestCamera_GetCalibration
+    // SENSOR_TIMESTAMP, boot time, never converted: the encoder only keeps microseconds,
+    // so the full value comes from the frame's capture result when it is still known
+    int64_t sensorTimestampNs;
+    float intrinsics[kIntrinsicsSize];
+    float distortion[kDistortionSize];
+    float pose[kPoseSize];
+};
+static_assert(sizeof(CalibrationSample) == 88, "Calibration track layout changed");
+
+struct Recorder {
+    RecorderConfig config;
+    AMediaCodec* codec = nullptr;
+    AMediaMuxer* muxer = nullptr;
+    ANativeWindow* window = nullptr;
+    int fd = -1;
+    std::thread drainThread;
+    std::atomic<bool> stopping{false};
+
+    // The camera opens with its calibration published and every frame of the session is
+    // captured with it, so it is read once at start rather than as frames drain
+    CameraCalibration calibration;
+    uint32_t calibrationVersion = 0;
+
+    // Only touched by the drain thread while it runs
+    ssize_t videoTrack = -1;
+    ssize_t calibrationTrack = -1;
+    bool muxerStarted = false;
+    uint64_t framesWritten = 0;
+};
+
+Recorder g_recorders[2];
+std::mutex g_recorderMutex;  // Guards start/stop, never taken by the drain thread
+
+inline int eyeIndex(bool isLeft) { return isLeft ? 0 : 1; }
+
+// Tracks can only be added before the muxer starts, and the video track needs the
+// encoder's output format (with its codec config), so this waits for the first one
+void startMuxer(Recorder& rec) {
+    AMediaFormat* videoFormat = AMediaCodec_getOutputFormat(rec.codec);
+    rec.videoTrack = AMediaMuxer_addTrack(rec.muxer, videoFormat);
+    AMediaFormat_delete(videoFormat);
+    if (rec.videoTrack < 0) {
+        LOGE("Failed to add the %s video track: %zd", rec.config.isLeft ? "left" : "right", rec.videoTrack);
+        return;
+    }
+
+    AMediaFormat* calibrationFormat = AMediaFormat_new();
+    AMediaFormat_setString(calibrationFormat, AMEDIAFORMAT_KEY_MIME, kCalibrationMime);
+    rec.calibrationTrack = AMediaMuxer_addTrack(rec.muxer, calibrationFormat);
+    AMediaFormat_delete(calibrationFormat);
+    if (rec.calibrationTrack < 0) {
+        LOGW("Calibration track not supported by the muxer, recording video only");
+    }
+
+    media_status_t status = AMediaMuxer_start(rec.muxer);
+    if (status != AMEDIA_OK) {
+        LOGE("AMediaMuxer_start failed: %d", status);
+        return;
+    }
+    rec.muxerStarted = true;
+}
+
+void writeCalibrationSample(Recorder& rec, int64_t presentationTimeUs) {
+    CalibrationSample sample;
+    sample.layout = kCalibrationSampleLayout;
+    sample.calibrationVersion = rec.calibrationVersion;
+    // The surface passes the camera buffer timestamp through, truncated to microseconds
+    if (!findSensorTimestamp(rec.config.isLeft, presentationTimeUs, &sample.sensorTimestampNs)) {
+        sample.sensorTimestampNs = presentationTimeUs * 1000;
+    }
+    memcpy(sample.intrinsics, rec.calibration.intrinsics, sizeof(sample.intrinsics));
+    memcpy(sample.distortion, rec.calibration.distortion, sizeof(sample.distortion));
+    memcpy(sample.pose, rec.calibration.pose, sizeof(sample.pose));
+
+    AMediaCodecBufferInfo info;
+    info.offset = 0;
+    info.size = sizeof(sample);
+    info.presentationTimeUs = presentationTimeUs;
+    info.flags = 0;
+    AMediaMuxer_writeSampleData(rec.muxer, rec.calibrationTrack,
+                                reinterpret_cast<const uint8_t*>(&sample), &info);
+}
+
+// Moves encoded frames into the muxer until the encoder reports end of stream
+void drainLoop(Recorder* rec) {
+    int idlePolls = 0;
+    AMediaCodecBufferInfo info;
+    for (;;) {
+        const ssize_t index = AMediaCodec_dequeueOutputBuffer(rec->codec, &info, kDrainTimeoutUs);
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+            // The camera may already be gone, do not wait forever for its last frame
+            if (rec->stopping.load(std::memory_order_relaxed) && ++idlePolls > kEndOfStreamWaitPolls) {
+                LOGW("%s encoder never reported end of stream", rec->config.isLeft ? "Left" : "Right");
+                return;
+            }
+            continue;
+        }
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            if (!rec->muxerStarted) {
+                startMuxer(*rec);
+            }
+            continue;
+        }
+        if (index < 0) {
+            // AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED, nothing to do with getOutputBuffer
+            continue;
+        }
+
+        idlePolls = 0;
+        size_t capacity = 0;
+        uint8_t* data = AMediaCodec_getOutputBuffer(rec->codec, index, &capacity);
+        // Codec config is already part of the track format
+        const bool isFrame = (info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) == 0 && info.size > 0;
+        if (data && isFrame && rec->muxerStarted) {
+            AMediaMuxer_writeSampleData(rec->muxer, rec->videoTrack, data, &info);
+            if (rec->calibrationTrack >= 0) {
+                writeCalibrationSample(*rec, info.presentationTimeUs);
+            }
+            ++rec->framesWritten;
+        }
+        AMediaCodec_releaseOutputBuffer(rec->codec, index, false);
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+            return;
+        }
+    }
+}
+
+void releaseRecorderLocked(Recorder& rec) {
+    if (rec.drainThread.joinable()) {
+        rec.drainThread.join();
+    }
+    if (rec.codec) {
+        AMediaCodec_stop(rec.codec);
+        AMediaCodec_delete(rec.codec);
+    }
+    if (rec.muxer) {
+        if (rec.muxerStarted) {
+            AMediaMuxer_stop(rec.muxer);
+        }
+        AMediaMuxer_delete(rec.muxer);
+    }
+    if (rec.window) {
+        ANativeWindow_release(rec.window);
+    }
+    if (rec.fd >= 0) {
+        close(rec.fd);
+    }
+
+    rec.codec = nullptr;
+    rec.muxer = nullptr;
+    rec.window = nullptr;
+    rec.fd = -1;
+    rec.videoTrack = -1;
+    rec.calibrationTrack = -1;
+    rec.muxerStarted = false;
+    rec.framesWritten = 0;
+    rec.stopping.store(false, std::memory_order_relaxed);
+}
+
+void stopRecordingLocked(Recorder& rec) {
+    if (!rec.codec) {
+        return;
+    }
+    rec.stopping.store(true, std::memory_order_relaxed);
+    AMediaCodec_signalEndOfInputStream(rec.codec);
+    if (rec.drainThread.joinable()) {
+        rec.drainThread.join();
+    }
+    LOGD("Finished %s recording, %llu frames", rec.config.isLeft ? "left" : "right",
+         static_cast<unsigned long long>(rec.framesWritten));
+    releaseRecorderLocked(rec);
+}
+
+} // namespace
+
+bool startRecording(const RecorderConfig& config, const char* path, ANativeWindow** outWindow) {
+    std::lock_guard<std::mutex> lock(g_recorderMutex);
+    Recorder& rec = g_recorders[eyeIndex(config.isLeft)];
+    stopRecordingLocked(rec);
+
+    const int32_t fps = config.fps > 0 ? config.fps : kDefaultFps;
+    const int32_t bitrate = config.bitrate > 0
+        ? config.bitrate
+        : static_cast<int32_t>(config.width * config.height * fps * kDefaultBitsPerPixel);
+    const char* mime = config.hevc ? "video/hevc" : "video/avc";
+
+    rec.config = config;
+    rec.calibrationVersion = readCalibration(config.isLeft, &rec.calibration);
+    rec.fd = open(path, O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (rec.fd < 0) {
+        LOGE("Cannot open recording file %s", path);
+        releaseRecorderLocked(rec);
+        return false;
+    }
+    rec.muxer = AMediaMuxer_new(rec.fd, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4);
+    rec.codec = AMediaCodec_createEncoderByType(mime);
+    if (!rec.muxer || !rec.codec) {
+        LOGE("No %s encoder or MP4 muxer available", mime);
+        releaseRecorderLocked(rec);
+        return false;
+    }
+
+    AMediaFormat* format = AMediaFormat_new();
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mime);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, config.width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, config.height);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, bitrate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, fps);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, kIFrameIntervalSeconds);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, kColorFormatSurface);
+    media_status_t status = AMediaCodec_configure(rec.codec, format, nullptr, nullptr,
+                                                  AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
+    AMediaFormat_delete(format);
+    if (status != AMEDIA_OK) {
+        LOGE("Encoder rejected %s %dx%d at %d fps, %d bps: %d", mime, config.width, config.height,
+             fps, bitrate, status);
+        releaseRecorderLocked(rec);
+        return false;
+    }
+
+    // Must be created between configure and start
+    status = AMediaCodec_createInputSurface(rec.codec, &rec.window);
+    if (status != AMEDIA_OK || !rec.window) {
+        LOGE("AMediaCodec_createInputSurface failed: %d", status);
+        rec.window = nullptr;
+        releaseRecorderLocked(rec);
+        return false;
+    }
+    status = AMediaCodec_start(rec.codec);
+    if (status != AMEDIA_OK) {
+        LOGE("AMediaCodec_start failed: %d", status);
+        releaseRecorderLocked(rec);
+        return false;
+    }
+
+    rec.drainThread = std::thread(drainLoop, &rec);
+    LOGD("Recording %s eye to %s (%s %dx%d, %d fps, %d bps)", config.isLeft ? "left" : "right",
+         path, mime, config.width, config.height, fps, bitrate);
+    *outWindow = rec.window;
+    return true;
+}
+
+void stopRecording(bool isLeft) {
+    std::lock_guard<std::mutex> lock(g_recorderMutex);
+    stopRecordingLocked(g_recorders[eyeIndex(isLeft)]);
+}
+
+} // namespace questcamera
@@ -0,0 +1,42 @@
+/*
+ * Quest Camera Plugin for Unity - Hardware encoded recording
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/native_window.h>
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+struct RecorderConfig {
+    bool isLeft = true;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t fps = 0;       // Encoder rate hint, 0 = 30
+    int32_t bitrate = 0;   // Bits per second, 0 = derived from size and rate
+    bool hevc = false;     // H.265 instead of H.264
+};
+
+// Creates one eye's encoder and MP4 muxer and returns the encoder's input surface
+// (owned by the recorder). The camera renders into it as an extra session output, so
+// frames reach the encoder without a CPU copy. Replaces a recording already running.
+bool startRecording(const RecorderConfig& config, const char* path, ANativeWindow** outWindow);
+
+// Ends the stream, waits for the encoder to drain and finalizes the file. Safe to call
+// when the eye is not recording.
+void stopRecording(bool isLeft);
+
+} // namespace questcamera
@@ -0,0 +1,454 @@
+/*
+ * Quest Camera Plugin for Unity - Lens undistortion and stereo rectification
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraRectify"
+
+#include "questcamera_rectify.h"
+#include "questcamera_api.h"
+#include "questcamera_metadata.h"
+#include "questcamera_stats.h"
+#include "questcamera_workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace questcamera {
+namespace {
+
+static_assert(sizeof(QuestCameraRectification::intrinsics) == sizeof(CameraCalibration::intrinsics),
+              "Rectified intrinsics must match the calibration layout");
+
+// Bilinear weights are 5-bit fractions, so a full tap-weighted sum fits 32 bits and one
+// row of horizontally weighted taps 16 bits
+constexpr int kFracBits = 5;
+constexpr int32_t kFracOne = 1 << kFracBits;
+constexpr int32_t kRowsPerBand = 32;
+
+// Top-left source tap of one output sample and its fractional offsets
+struct RemapEntry {
+    uint16_t x;
+    uint16_t y;
+    uint8_t ax;  // 0..kFracOne, weight of the right column
+    uint8_t ay;  // 0..kFracOne, weight of the bottom row
+};
+
+static_assert(sizeof(RemapEntry) == 6, "RemapEntry should stay packed");
+
+struct Mat3 {
+    float m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};  // Row-major
+
+    float operator()(int row, int col) const { return m[row * 3 + col]; }
+};
+
+struct Vec3 {
+    float x, y, z;
+};
+
+Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+float length(const Vec3& v) { return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z); }
+Vec3 normalize(const Vec3& v) {
+    const float len = length(v);
+    return {v.x / len, v.y / len, v.z / len};
+}
+
+Mat3 multiply(const Mat3& a, const Mat3& b) {
+    Mat3 out;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            out.m[row * 3 + col] = a(row, 0) * b(0, col) + a(row, 1) * b(1, col) + a(row, 2) * b(2, col);
+        }
+    }
+    return out;
+}
+
+Mat3 transpose(const Mat3& a) {
+    Mat3 out;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            out.m[row * 3 + col] = a(col, row);
+        }
+    }
+    return out;
+}
+
+// LENS_POSE_ROTATION (x, y, z, w): the rotation from the device's sensor coordinate
+// system into the camera's, x right, y down, z along the optical axis
+Mat3 poseRotation(const CameraCalibration& calibration) {
+    const float* q = calibration.pose + 3;
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    if (x == 0 && y == 0 && z == 0 && w == 0) {
+        return Mat3();
+    }
+    Mat3 r;
+    r.m[0] = 1 - 2 * (y * y + z * z);
+    r.m[1] = 2 * (x * y - z * w);
+    r.m[2] = 2 * (x * z + y * w);
+    r.m[3] = 2 * (x * y + z * w);
+    r.m[4] = 1 - 2 * (x * x + z * z);
+    r.m[5] = 2 * (y * z - x * w);
+    r.m[6] = 2 * (x * z - y * w);
+    r.m[7] = 2 * (y * z + x * w);
+    r.m[8] = 1 - 2 * (x * x + y * y);
+    return r;
+}
+
+Vec3 poseTranslation(const CameraCalibration& calibration) {
+    return {calibration.pose[0], calibration.pose[1], calibration.pose[2]};
+}
+
+struct RemapTable {
+    int32_t width = 0;
+    int32_t height = 0;
+    bool chroma = false;
+    std::vector<RemapEntry> luma;        // width * height
+    std::vector<RemapEntry> chromaMap;   // (width / 2) * (height / 2), in chroma samples
+};
+
+struct TableKey {
+    uint32_t versions[2] = {};
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t mode = QUESTCAMERA_RECTIFY_OFF;
+
+    bool operator==(const TableKey& other) const {
+        return versions[0] == other.versions[0] && versions[1] == other.versions[1] &&
+               width == other.width && height == other.height && mode == other.mode;
+    }
+};
+
+// Owned by the eye's image thread; the mutex only matters if replay runs next to capture
+struct EyeRectifier {
+    std::mutex mutex;
+    TableKey key;
+    RemapTable table;
+    std::vector<uint8_t> output;  // Packed NV12 or luma, reused across frames
+};
+
+std::atomic<int32_t> g_rectifyMode{QUESTCAMERA_RECTIFY_OFF};
+EyeRectifier g_rectifiers[2];
+
+// What QuestCamera_GetRectification returns, updated whenever a table is rebuilt
+std::mutex g_infoMutex;  // Never held across a build or a remap
+QuestCameraRectification g_info[2] = {};
+uint32_t g_infoVersion = 0;  // Guarded by g_infoMutex
+
+// Maps output samples of one plane to source samples. scale is the plane's subsampling
+// (1 luma, 2 chroma); positions are converted through full-resolution pixel centres.
+void buildMap(const CameraCalibration& calibration, const Mat3& rectToCamera,
+              const QuestCameraRectification& rectified, int32_t planeWidth, int32_t planeHeight,
+              int32_t scale, std::vector<RemapEntry>* map) {
+    const float fx = calibration.intrinsics[0], fy = calibration.intrinsics[1];
+    const float cx = calibration.intrinsics[2], cy = calibration.intrinsics[3];
+    const float skew = calibration.intrinsics[4];
+    const float* d = calibration.distortion;  // k1, k2, k3, p1, p2, k4
+    const float outFx = rectified.intrinsics[0], outFy = rectified.intrinsics[1];
+    const float outCx = rectified.intrinsics[2], outCy = rectified.intrinsics[3];
+    const float maxX = static_cast<float>(planeWidth - 1);
+    const float maxY = static_cast<float>(planeHeight - 1);
+
+    map->resize(static_cast<size_t>(planeWidth) * planeHeight);
+    RemapEntry* entry = map->data();
+    for (int32_t row = 0; row < planeHeight; ++row) {
+        const float v = (row + 0.5f) * scale - 0.5f;
+        const float ry = (v - outCy) / outFy;
+        for (int32_t col = 0; col < planeWidth; ++col, ++entry) {
+            const float u = (col + 0.5f) * scale - 0.5f;
+            const float rx = (u - outCx) / outFx;
+            const float px = rectToCamera(0, 0) * rx + rectToCamera(0, 1) * ry + rectToCamera(0, 2);
+            const float py = rectToCamera(1, 0) * rx + rectToCamera(1, 1) * ry + rectToCamera(1, 2);
+            const float pz = rectToCamera(2, 0) * rx + rectToCamera(2, 1) * ry + rectToCamera(2, 2);
+
+            float sx = 0;
+            float sy = 0;
+            if (pz > 1e-6f) {
+                // LENS_DISTORTION maps ideal normalized coordinates to distorted ones
+                const float x = px / pz;
+                const float y = py / pz;
+                const float r2 = x * x + y * y;
+                const float radial = 1 + r2 * (d[0] + r2 * (d[1] + r2 * (d[2] + r2 * d[5])));
+                const float xd = x * radial + 2 * d[3] * x * y + d[4] * (r2 + 2 * x * x);
+                const float yd = y * radial + d[3] * (r2 + 2 * y * y) + 2 * d[4] * x * y;
+                sx = ((fx * xd + skew * yd + cx) + 0.5f) / scale - 0.5f;
+                sy = ((fy * yd + cy) + 0.5f) / scale - 0.5f;
+            }
+
+            // Samples outside the sensor repeat its border
+            sx = std::clamp(sx, 0.0f, maxX);
+            sy = std::clamp(sy, 0.0f, maxY);
+            const int32_t x0 = std::min(static_cast<int32_t>(sx), std::max(planeWidth - 2, 0));
+            const int32_t y0 = std::min(static_cast<int32_t>(sy), std::max(planeHeight - 2, 0));
+            entry->x = static_cast<uint16_t>(x0);
+            entry->y = static_cast<uint16_t>(y0);
+            entry->ax = static_cast<uint8_t>(std::lround((sx - x0) * kFracOne));
+            entry->ay = static_cast<uint8_t>(std::lround((sy - y0) * kFracOne));
+        }
+    }
+}
+
+// Shared rectified frame of both eyes when both calibrations are known: x along the
+// baseline, z the mean optical axis, one pinhole camera for both. Otherwise the eye is
+// only undistorted, keeping its own orientation and focal lengths.
+void computeRectification(bool isLeft, const CameraCalibration calibrations[2], bool stereo,
+                          int32_t width, int32_t height, Mat3* rectToCamera,
+                          QuestCameraRectification* info) {
+    const CameraCalibration& own = calibrations[isLeft ? 0 : 1];
+    memset(info, 0, sizeof(*info));
+    info->width = width;
+    info->height = height;
+
+    if (stereo) {
+        const Mat3 left = poseRotation(calibrations[0]);
+        const Mat3 right = poseRotation(calibrations[1]);
+        const Vec3 baseline = poseTranslation(calibrations[1]) - poseTranslation(calibrations[0]);
+        // Third rows are each camera's optical axis in device coordinates
+        const Vec3 axis = normalize(Vec3{left(2, 0), left(2, 1), left(2, 2)} +
+                                    Vec3{right(2, 0), right(2, 1), right(2, 2)});
+        if (length(baseline) > 1e-4f) {
+            const Vec3 e1 = normalize(baseline);
+            const Vec3 e2 = normalize(cross(axis, e1));
+            const Vec3 e3 = cross(e1, e2);
+            const Mat3 deviceToRect{{e1.x, e1.y, e1.z, e2.x, e2.y, e2.z, e3.x, e3.y, e3.z}};
+            *rectToCamera = multiply(isLeft ? left : right, transpose(deviceToRect));
+
+            const float focal = (calibrations[0].intrinsics[0] + calibrations[0].intrinsics[1] +
+                                 calibrations[1].intrinsics[0] + calibrations[1].intrinsics[1]) / 4;
+            info->stereo = 1;
+            info->intrinsics[0] = focal;
+            info->intrinsics[1] = focal;
+            info->intrinsics[2] = (calibrations[0].intrinsics[2] + calibrations[1].intrinsics[2]) / 2;
+            info->intrinsics[3] = (calibrations[0].intrinsics[3] + calibrations[1].intrinsics[3]) / 2;
+            info->baselineMeters = length(baseline);
+            memcpy(info->rotation, rectToCamera->m, sizeof(info->rotation));
+            return;
+        }
+        LOGW("Camera poses share one position, undistorting without rectification");
+    }
+
+    *rectToCamera = Mat3();
+    info->intrinsics[0] = own.intrinsics[0];
+    info->intrinsics[1] = own.intrinsics[1];
+    info->intrinsics[2] = own.intrinsics[2];
+    info->intrinsics[3] = own.intrinsics[3];
+    memcpy(info->rotation, rectToCamera->m, sizeof(info->rotation));
+}
+
+bool hasIntrinsics(const CameraCalibration& calibration) {
+    return calibration.intrinsics[0] > 0 && calibration.intrinsics[1] > 0;
+}
+
+// Called with the eye's mutex held. Takes tens of milliseconds at full resolution, once
+// per session, so it stays on the image thread rather than racing a second table build.
+bool rebuildTable(bool isLeft, EyeRectifier& eye, const TableKey& key,
+                  const CameraCalibration calibrations[2]) {
+    TraceSection section("QuestCamera rectify table");
+    const CameraCalibration& own = calibrations[isLeft ? 0 : 1];
+    if (key.versions[isLeft ? 0 : 1] == 0 || !hasIntrinsics(own)) {
+        LOGE_THROTTLED(5000, "No %s calibration to rectify with", isLeft ? "left" : "right");
+        return false;
+    }
+
+    const bool stereo = key.versions[0] != 0 && key.versions[1] != 0 &&
+                        hasIntrinsics(calibrations[0]) && hasIntrinsics(calibrations[1]);
+    Mat3 rectToCamera;
+    QuestCameraRectification info;
+    computeRectification(isLeft, calibrations, stereo, key.width, key.height, &rectToCamera, &info);
+
+    RemapTable& table = eye.table;
+    table.width = key.width;
+    table.height = key.height;
+    table.chroma = key.mode == QUESTCAMERA_RECTIFY_NV12;
+    buildMap(own, rectToCamera, info, key.width, key.height, 1, &table.luma);
+    if (table.chroma) {
+        buildMap(own, rectToCamera, info, key.width / 2, key.height / 2, 2, &table.chromaMap);
+    } else {
+        table.chromaMap.clear();
+        table.chromaMap.shrink_to_fit();
+    }
+    eye.key = key;
+
+    std::lock_guard<std::mutex> lock(g_infoMutex);
+    info.version = ++g_infoVersion;
+    g_info[isLeft ? 0 : 1] = info;
+    LOGD("Built %s %s table %dx%d", isLeft ? "left" : "right", stereo ? "rectification" : "undistortion",
+         key.width, key.height);
+    return true;
+}
+
+inline uint8_t bilinear(const uint8_t* src, int32_t stride, int32_t pixelStride, const RemapEntry& e) {
+    const uint8_t* p = src + e.y * stride + e.x * pixelStride;
+    const int32_t top = p[0] * (kFracOne - e.ax) + p[pixelStride] * e.ax;
+    const int32_t bottom = p[stride] * (kFracOne - e.ax) + p[stride + pixelStride] * e.ax;
+    return static_cast<uint8_t>((top * (kFracOne - e.ay) + bottom * e.ay + (1 << (2 * kFracBits - 1))) >>
+                                (2 * kFracBits));
+}
+
+#if defined(__ARM_NEON)
+// NEON has no byte gather, so the four taps are loaded per sample and only the
+// weighting runs eight lanes wide. Rounds exactly like bilinear().
+inline uint8x8_t bilinear8(const uint8_t* src, int32_t stride, int32_t pixelStride, const RemapEntry* e) {
+    uint8_t topLeft[8], topRight[8], bottomLeft[8], bottomRight[8], ax[8], ay[8];
+    for (int i = 0; i < 8; ++i) {
+        const uint8_t* p = src + e[i].y * stride + e[i].x * pixelStride;
+        topLeft[i] = p[0];
+        topRight[i] = p[pixelStride];
+        bottomLeft[i] = p[stride];
+        bottomRight[i] = p[stride + pixelStride];
+        ax[i] = e[i].ax;
+        ay[i] = e[i].ay;
+    }
+    const uint8x8_t wx = vld1_u8(ax);
+    const uint8x8_t wx0 = vsub_u8(vdup_n_u8(kFracOne), wx);
+    const uint16x8_t top = vmlal_u8(vmull_u8(vld1_u8(topLeft), wx0), vld1_u8(topRight), wx);
+    const uint16x8_t bottom = vmlal_u8(vmull_u8(vld1_u8(bottomLeft), wx0), vld1_u8(bottomRight), wx);
+    const uint16x8_t wy = vmovl_u8(vld1_u8(ay));
+    const uint16x8_t wy0 = vsubq_u16(vdupq_n_u16(kFracOne), wy);
+    const uint32x4_t low = vmlal_u16(vmull_u16(vget_low_u16(top), vget_low_u16(wy0)),
+                                     vget_low_u16(bottom), vget_low_u16(wy));
+    const uint32x4_t high = vmlal_u16(vmull_u16(vget_high_u16(top), vget_high_u16(wy0)),
+                                      vget_high_u16(bottom), vget_high_u16(wy));
+    return vmovn_u16(vcombine_u16(vrshrn_n_u32(low, 2 * kFracBits), vrshrn_n_u32(high, 2 * kFracBits)));
+}
+#endif
+
+// Output samples [begin, end) of the luma plane
+void remapLuma(const FrameView& frame, const RemapTable& table, uint8_t* dst, int32_t begin, int32_t end) {
+    const RemapEntry* entries = table.luma.data();
+    int32_t i = begin;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= end; i += 8) {
+        vst1_u8(dst + i, bilinear8(frame.yData, frame.yRowStride, 1, entries + i));
+    }
+#endif
+    for (; i < end; ++i) {
+        dst[i] = bilinear(frame.yData, frame.yRowStride, 1, entries[i]);
+    }
+}
+
+// Chroma samples [begin, end) as interleaved UV, whatever the source chroma layout
+void remapChroma(const FrameView& frame, const RemapTable& table, uint8_t* dst, int32_t begin, int32_t end) {
+    const RemapEntry* entries = table.chromaMap.data();
+    const uint8_t* uPlane = frame.uvData;
+    const uint8_t* vPlane = frame.vData ? frame.vData : frame.uvData + 1;
+    const int32_t stride = frame.uvRowStride;
+    const int32_t pixelStride = frame.uvPixelStride;
+    int32_t i = begin;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= end; i += 8) {
+        uint8x8x2_t uv;
+        uv.val[0] = bilinear8(uPlane, stride, pixelStride, entries + i);
+        uv.val[1] = bilinear8(vPlane, stride, pixelStride, entries + i);
+        vst2_u8(dst + i * 2, uv);
+    }
+#endif
+    for (; i < end; ++i) {
+        dst[i * 2] = bilinear(uPlane, stride, pixelStride, entries[i]);
+        dst[i * 2 + 1] = bilinear(vPlane, stride, pixelStride, entries[i]);
+    }
+}
+
+} // namespace
+
+void emitRectifiedFrame(bool isLeft, const FrameView& frame) {
+    const int32_t mode = g_rectifyMode.load(std::memory_order_relaxed);
+    if (mode == QUESTCAMERA_RECTIFY_OFF) {
+        return;
+    }
+    RectifiedFrameCallback callback = g_rectifiedFrameCallback.load();
+    if (!callback || frame.width < 2 || frame.height < 2 || frame.width > UINT16_MAX ||
+        frame.height > UINT16_MAX) {
+        return;
+    }
+
+    EyeRectifier& eye = g_rectifiers[isLeft ? 0 : 1];
+    std::lock_guard<std::mutex> lock(eye.mutex);
+    TableKey key;
+    key.versions[0] = calibrationVersion(true);
+    key.versions[1] = calibrationVersion(false);
+    key.width = frame.width;
+    key.height = frame.height;
+    key.mode = mode;
+    if (!(key == eye.key)) {
+        CameraCalibration calibrations[2];
+        key.versions[0] = readCalibration(true, &calibrations[0]);
+        key.versions[1] = readCalibration(false, &calibrations[1]);
+        if (!rebuildTable(isLeft, eye, key, calibrations)) {
+            return;
+        }
+    }
+
+    const RemapTable& table = eye.table;
+    const size_t lumaSize = static_cast<size_t>(table.width) * table.height;
+    eye.output.resize(table.chroma ? lumaSize * 3 / 2 : lumaSize);
+    uint8_t* yOut = eye.output.data();
+    uint8_t* uvOut = table.chroma ? yOut + lumaSize : nullptr;
+    {
+        // Luma rows first, then the chroma rows, banded across the frame workers
+        TraceSection section("QuestCamera rectify");
+        const int32_t chromaWidth = table.width / 2;
+        const int32_t chromaRows = table.chroma ? table.height / 2 : 0;
+        parallelFor(table.height + chromaRows, kRowsPerBand, [&](int32_t begin, int32_t end) {
+            const int32_t lumaEnd = std::min(end, table.height);
+            if (begin < lumaEnd) {
+                remapLuma(frame, table, yOut, begin * table.width, lumaEnd * table.width);
+            }
+            const int32_t chromaBegin = std::max(begin, table.height) - table.height;
+            const int32_t chromaEnd = end - table.height;
+            if (chromaBegin < chromaEnd) {
+                remapChroma(frame, table, uvOut, chromaBegin * chromaWidth, chromaEnd * chromaWidth);
+            }
+        });
+    }
+    invokeCallback("QuestCamera rectified callback", callback,
+                   static_cast<const uint8_t*>(yOut), static_cast<const uint8_t*>(uvOut),
+                   table.width, table.height, frame.sequence, frame.timestamp, isLeft);
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetRectification(int32_t mode) {
+    if (mode != QUESTCAMERA_RECTIFY_OFF && mode != QUESTCAMERA_RECTIFY_LUMA &&
+        mode != QUESTCAMERA_RECTIFY_NV12) {
+        LOGE("Unsupported rectification mode %d", mode);
+        return false;
+    }
+    LOGD("Setting rectification mode: %d", mode);
+    g_rectifyMode.store(mode, std::memory_order_relaxed);
+    return true;
+}
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_GetRectification(bool isLeft,
+                                                               QuestCameraRectification* outRectification) {
+    if (!outRectification) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_infoMutex);
+    *outRectification = g_info[isLeft ? 0 : 1];
+    return outRectification->version != 0;
+}
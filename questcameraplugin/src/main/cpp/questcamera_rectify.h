@@ -0,0 +1,28 @@
+/*
+ * Quest Camera Plugin for Unity - Lens undistortion and stereo rectification
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// Remaps the frame through the eye's undistortion/rectification table and hands the result
+// to RectifiedFrameCallback, on the calling image thread. The table is rebuilt there when
+// either eye's calibration version or the frame size changed. No-op while disabled.
+void emitRectifiedFrame(bool isLeft, const FrameView& frame);
+
+} // namespace questcamera
@@ -0,0 +1,118 @@
+/*
+ * Quest Camera Plugin for Unity - Lock-free frame ring
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace questcamera {
+
+// Single-producer/single-consumer ring with a latest-wins policy.
+//
+// head and tail are monotonically increasing sequence numbers; slot = seq % size.
+// The producer owns head, tail is advanced by the consumer when it takes a frame
+// and by the producer when it drops the oldest queued frame, both with CAS.
+// The consumer keeps the slot it last took ("held") until its next acquire, and
+// the producer never writes into it, so the consumer can read slot memory in
+// place without copying. All slots are preallocated by the owner.
+template <typename Slot>
+class FrameRing {
+public:
+    static constexpr uint64_t kNoneHeld = UINT64_MAX;
+
+    // Not thread-safe, only call while neither side is running
+    void reset(size_t slotCount) {
+        slots_.clear();
+        slots_.resize(slotCount < 2 ? 2 : slotCount);
+        head_.store(0);
+        tail_.store(0);
+        held_.store(kNoneHeld);
+        dropped_.store(0);
+    }
+
+    size_t size() const { return slots_.size(); }
+    Slot& slotAt(size_t index) { return slots_[index]; }
+
+    // Producer: slot to fill for the next frame, or nullptr if the frame has to be
+    // dropped because the consumer still holds the only free slot.
+    Slot* beginWrite() {
+        const uint64_t count = slots_.size();
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+
+        // Latest wins: make room by dropping the oldest queued frame
+        uint64_t tail = tail_.load();
+        while (head - tail >= count) {
+            if (tail_.compare_exchange_weak(tail, tail + 1)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                tail = tail + 1;
+            }
+        }
+
+        // Loaded after tail, see acquireLatest for the ordering argument
+        const uint64_t held = held_.load();
+        if (held != kNoneHeld && head - held >= count) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots_[head % count];
+    }
+
+    void commitWrite() {
+        head_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Consumer: newest queued frame, older ones are dropped. The returned slot stays
+    // valid until the next acquireLatest or releaseHeld call.
+    Slot* acquireLatest() {
+        uint64_t tail = tail_.load();
+        for (;;) {
+            const uint64_t head = head_.load(std::memory_order_acquire);
+            if (tail == head) {
+                // Nothing new, the previously returned frame is no longer in use either
+                held_.store(kNoneHeld);
+                return nullptr;
+            }
+            const uint64_t newest = head - 1;
+
+            // Publish the claim before moving tail. A producer that sees the new tail
+            // also sees held, and one that sees the old tail cannot reach this slot.
+            held_.store(newest);
+            if (tail_.compare_exchange_strong(tail, head)) {
+                dropped_.fetch_add(newest - tail, std::memory_order_relaxed);
+                return &slots_[newest % slots_.size()];
+            }
+            // The producer dropped a frame meanwhile, tail was reloaded by the CAS
+        }
+    }
+
+    void releaseHeld() {
+        held_.store(kNoneHeld);
+    }
+
+    uint64_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> held_{kNoneHeld};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace questcamera
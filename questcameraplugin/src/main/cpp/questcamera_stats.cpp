@@ -0,0 +1,301 @@
+/*
+ * Quest Camera Plugin for Unity - Pipeline latency counters and trace sections
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraStats"
+
+#include "questcamera_stats.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+#include "questcamera_queue.h"
+
+#include <atomic>
+#include <ctime>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+constexpr int kBuckets = QUESTCAMERA_HISTOGRAM_BUCKETS;
+constexpr int kStageCount = static_cast<int>(Stage::Count);
+
+// Bucket 0 is below 1us, bucket i covers [2^(i-1), 2^i) us and the last one is open-ended
+int bucketFor(int64_t durationNs) {
+    const uint64_t us = durationNs > 0 ? static_cast<uint64_t>(durationNs) / 1000 : 0;
+    const int bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+}
+
+int64_t bucketUpperBoundNs(int bucket) {
+    return (int64_t{1} << bucket) * 1000;
+}
+
+struct Histogram {
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> sumNs{0};
+    std::atomic<int64_t> maxNs{0};
+
+    void record(int64_t durationNs) {
+        if (durationNs < 0) {
+            // Clock or timestamp domain mismatch, not a latency
+            return;
+        }
+        buckets[bucketFor(durationNs)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(durationNs, std::memory_order_relaxed);
+        int64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (durationNs > seen &&
+               !maxNs.compare_exchange_weak(seen, durationNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sumNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    // Percentiles are the upper bound of the bucket they fall in
+    void snapshot(QuestCameraStageStats* out) const {
+        uint64_t total = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            out->buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            total += out->buckets[i];
+        }
+        out->count = total;
+        out->meanNs = total ? sumNs.load(std::memory_order_relaxed) / static_cast<int64_t>(total) : 0;
+        out->maxNs = maxNs.load(std::memory_order_relaxed);
+        out->p50Ns = 0;
+        out->p99Ns = 0;
+        uint64_t running = 0;
+        for (int i = 0; i < kBuckets && total; ++i) {
+            running += out->buckets[i];
+            if (out->p50Ns == 0 && running * 2 >= total) {
+                out->p50Ns = bucketUpperBoundNs(i);
+            }
+            if (running * 100 >= total * 99) {
+                out->p99Ns = bucketUpperBoundNs(i);
+                break;
+            }
+        }
+    }
+};
+
+// Written by the eye's capture thread only, reset may race with it harmlessly
+struct EyeCounters {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> captureDrops{0};
+    std::atomic<uint64_t> stereoDrops{0};
+    std::atomic<int64_t> lastSensorNs{0};
+    std::atomic<int64_t> intervalNs{0};  // Running estimate of the frame interval
+};
+
+Histogram g_stages[kStageCount];
+EyeCounters g_eyes[2];
+
+// Times since beginStartup, 0 until reached. Frame threads only touch pendingEyes and
+// firstFrameNs, and only after seeing their eye's bit in pendingEyes.
+struct StartupTracker {
+    std::mutex mutex;  // Begin, stages and failure, never taken on the frame path
+    std::atomic<uint32_t> pendingEyes{0};
+    std::atomic<int32_t> state{QUESTCAMERA_STARTUP_IDLE};
+    uint32_t eyes = 0;
+    int64_t startNs = 0;
+    std::atomic<int64_t> openedNs[2] = {};
+    std::atomic<int64_t> configuredNs[2] = {};
+    std::atomic<int64_t> firstFrameNs[2] = {};
+};
+
+StartupTracker g_startup;
+
+void reportStartup(int32_t status) {
+    StartupCallback callback = g_startupCallback.load();
+    if (callback) {
+        invokeCallback("QuestCamera startup callback", callback, status,
+                       g_startup.firstFrameNs[0].load(std::memory_order_relaxed),
+                       g_startup.firstFrameNs[1].load(std::memory_order_relaxed));
+    }
+}
+
+void noteFirstFrame(int eye, int64_t acquireNs) {
+    const uint32_t bit = eye == 0 ? QUESTCAMERA_EYE_LEFT : QUESTCAMERA_EYE_RIGHT;
+    const uint32_t before = g_startup.pendingEyes.fetch_and(~bit);
+    if ((before & bit) == 0) {
+        return;
+    }
+    const int64_t elapsedNs = acquireNs - g_startup.startNs;
+    g_startup.firstFrameNs[eye].store(elapsedNs, std::memory_order_relaxed);
+    LOGD("%s eye first frame %.1f ms after start", eye == 0 ? "Left" : "Right", elapsedNs / 1e6);
+    if ((before & ~bit) == 0) {
+        g_startup.state.store(QUESTCAMERA_STARTUP_STREAMING);
+        reportStartup(QUESTCAMERA_STARTUP_STREAMING);
+    }
+}
+
+} // namespace
+
+int64_t bootTimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+void recordStage(Stage stage, int64_t durationNs) {
+    g_stages[static_cast<int>(stage)].record(durationNs);
+}
+
+void recordFrameAcquired(bool isLeft, int64_t sensorTimestampNs, int64_t acquireNs,
+                         uint32_t decimatedBefore) {
+    recordStage(Stage::SensorToAcquire, acquireNs - sensorTimestampNs);
+
+    const uint32_t eyeBit = isLeft ? QUESTCAMERA_EYE_LEFT : QUESTCAMERA_EYE_RIGHT;
+    if (g_startup.pendingEyes.load(std::memory_order_relaxed) & eyeBit) {
+        noteFirstFrame(isLeft ? 0 : 1, acquireNs);
+    }
+
+    EyeCounters& eye = g_eyes[isLeft ? 0 : 1];
+    eye.frames.fetch_add(1 + decimatedBefore, std::memory_order_relaxed);
+    const int64_t last = eye.lastSensorNs.exchange(sensorTimestampNs, std::memory_order_relaxed);
+    if (last == 0 || sensorTimestampNs <= last) {
+        return;
+    }
+    if (decimatedBefore > 0) {
+        // The gap spans frames we skipped on purpose, it says nothing about the interval
+        return;
+    }
+
+    // The estimate only follows intervals close to it, so gaps do not inflate it
+    const int64_t delta = sensorTimestampNs - last;
+    const int64_t interval = eye.intervalNs.load(std::memory_order_relaxed);
+    if (interval == 0 || delta < interval * 3 / 2) {
+        eye.intervalNs.store(interval == 0 ? delta : (interval * 7 + delta) / 8,
+                             std::memory_order_relaxed);
+        return;
+    }
+    const int64_t missed = (delta + interval / 2) / interval - 1;
+    if (missed > 0) {
+        eye.captureDrops.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+    }
+}
+
+void recordStereoDrop(bool isLeft) {
+    g_eyes[isLeft ? 0 : 1].stereoDrops.fetch_add(1, std::memory_order_relaxed);
+}
+
+void resetFrameGaps() {
+    for (EyeCounters& eye : g_eyes) {
+        eye.lastSensorNs.store(0, std::memory_order_relaxed);
+        eye.intervalNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+void beginStartup(uint32_t eyes) {
+    resetFrameGaps();
+    std::lock_guard<std::mutex> lock(g_startup.mutex);
+    // Closed first so no frame thread still holds a bit of the previous start
+    g_startup.pendingEyes.store(0);
+    g_startup.eyes = eyes;
+    g_startup.startNs = bootTimeNs();
+    for (int eye = 0; eye < 2; ++eye) {
+        g_startup.openedNs[eye].store(0, std::memory_order_relaxed);
+        g_startup.configuredNs[eye].store(0, std::memory_order_relaxed);
+        g_startup.firstFrameNs[eye].store(0, std::memory_order_relaxed);
+    }
+    g_startup.state.store(eyes ? QUESTCAMERA_STARTUP_PENDING : QUESTCAMERA_STARTUP_IDLE);
+    g_startup.pendingEyes.store(eyes);
+}
+
+void markStartupStage(bool isLeft, StartupStage stage) {
+    std::lock_guard<std::mutex> lock(g_startup.mutex);
+    if (g_startup.state.load() != QUESTCAMERA_STARTUP_PENDING) {
+        return;
+    }
+    const int eye = isLeft ? 0 : 1;
+    std::atomic<int64_t>& slot = stage == StartupStage::Opened
+        ? g_startup.openedNs[eye] : g_startup.configuredNs[eye];
+    slot.store(bootTimeNs() - g_startup.startNs, std::memory_order_relaxed);
+}
+
+void failStartup() {
+    {
+        std::lock_guard<std::mutex> lock(g_startup.mutex);
+        if (g_startup.state.load() != QUESTCAMERA_STARTUP_PENDING) {
+            return;
+        }
+        g_startup.pendingEyes.store(0);
+        g_startup.state.store(QUESTCAMERA_STARTUP_FAILED);
+    }
+    reportStartup(QUESTCAMERA_STARTUP_FAILED);
+}
+
+void cancelStartup() {
+    std::lock_guard<std::mutex> lock(g_startup.mutex);
+    g_startup.pendingEyes.store(0);
+    if (g_startup.state.load() == QUESTCAMERA_STARTUP_PENDING) {
+        g_startup.state.store(QUESTCAMERA_STARTUP_IDLE);
+    }
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_GetStats(QuestCameraStats* outStats) {
+    if (!outStats) {
+        return;
+    }
+    g_stages[static_cast<int>(Stage::SensorToAcquire)].snapshot(&outStats->sensorToAcquire);
+    g_stages[static_cast<int>(Stage::AcquireToCopy)].snapshot(&outStats->acquireToCopy);
+    g_stages[static_cast<int>(Stage::Combine)].snapshot(&outStats->combine);
+    g_stages[static_cast<int>(Stage::Callback)].snapshot(&outStats->callback);
+    for (int eye = 0; eye < 2; ++eye) {
+        QuestCameraEyeStats& out = outStats->eyes[eye];
+        out.frames = g_eyes[eye].frames.load(std::memory_order_relaxed);
+        out.captureDrops = g_eyes[eye].captureDrops.load(std::memory_order_relaxed);
+        out.stereoDrops = g_eyes[eye].stereoDrops.load(std::memory_order_relaxed);
+        out.queueDrops = queueDroppedFrames(eye == 0);
+    }
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_GetStartupTiming(QuestCameraStartupTiming* outTiming) {
+    if (!outTiming) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_startup.mutex);
+    outTiming->state = g_startup.state.load();
+    outTiming->eyes = g_startup.eyes;
+    for (int eye = 0; eye < 2; ++eye) {
+        outTiming->openedNs[eye] = g_startup.openedNs[eye].load(std::memory_order_relaxed);
+        outTiming->configuredNs[eye] = g_startup.configuredNs[eye].load(std::memory_order_relaxed);
+        outTiming->firstFrameNs[eye] = g_startup.firstFrameNs[eye].load(std::memory_order_relaxed);
+    }
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_ResetStats(void) {
+    for (Histogram& stage : g_stages) {
+        stage.reset();
+    }
+    for (EyeCounters& eye : g_eyes) {
+        eye.frames.store(0, std::memory_order_relaxed);
+        eye.captureDrops.store(0, std::memory_order_relaxed);
+        eye.stereoDrops.store(0, std::memory_order_relaxed);
+    }
+    resetFrameGaps();
+    LOGD("Pipeline stats reset");
+}
@@ -0,0 +1,126 @@
+/*
+ * Quest Camera Plugin for Unity - Pipeline latency counters and trace sections
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+#if QUESTCAMERA_TRACE
+#include <android/trace.h>
+#endif
+
+namespace questcamera {
+
+enum class Stage : int {
+    SensorToAcquire = 0,  // Sensor timestamp until the image was acquired
+    AcquireToCopy,        // Acquire until the frame was packed for delivery
+    Combine,              // One eye's side-by-side write plus pairing
+    Callback,             // Time spent inside Unity callbacks
+    Count
+};
+
+// CLOCK_BOOTTIME, the clock camera timestamps are taken on
+int64_t bootTimeNs();
+
+// Lock-free, callable from any capture thread
+void recordStage(Stage stage, int64_t durationNs);
+
+// Once per acquired image with its raw sensor timestamp, before the global time offset.
+// Also counts frames the camera produced that never reached the plugin, from gaps in
+// the sensor timestamps. decimatedBefore frames were acquired and skipped by decimation
+// since the previous call; they count as frames and their gap is not a drop.
+void recordFrameAcquired(bool isLeft, int64_t sensorTimestampNs, int64_t acquireNs,
+                         uint32_t decimatedBefore = 0);
+
+// A frame the combiner discarded without finding its partner
+void recordStereoDrop(bool isLeft);
+
+// Forgets the last sensor timestamp and interval of both eyes, for when frames stop or
+// change rate on purpose (start, standby) so the next gap is not counted as drops
+void resetFrameGaps();
+
+enum class StartupStage : int {
+    Opened = 0,  // CameraDevice.StateCallback.onOpened
+    Configured,  // Capture session configured, repeating request sent
+};
+
+// Starts timing a camera start of the QUESTCAMERA_EYE_* bits in eyes, replacing any start
+// still pending. recordFrameAcquired notes each eye's first frame; once all arrived the
+// startup callback runs on the last eye's capture thread.
+void beginStartup(uint32_t eyes);
+void markStartupStage(bool isLeft, StartupStage stage);
+// Ends a pending start with the failure status, or silently for cancelStartup (camera stopped)
+void failStartup();
+void cancelStartup();
+
+// Records the time between construction and stop() or destruction
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), startNs_(bootTimeNs()) {}
+    ~StageTimer() { stop(); }
+
+    void stop() {
+        if (startNs_ != 0) {
+            recordStage(stage_, bootTimeNs() - startNs_);
+            startNs_ = 0;
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    Stage stage_;
+    int64_t startNs_;
+};
+
+// ATrace section, shows up in Perfetto and systrace captures with the "app" category.
+// Costs one ATrace_isEnabled call when tracing is off, nothing with QUESTCAMERA_TRACE=0.
+class TraceSection {
+public:
+#if QUESTCAMERA_TRACE
+    explicit TraceSection(const char* name) : active_(ATrace_isEnabled()) {
+        if (active_) {
+            ATrace_beginSection(name);
+        }
+    }
+    ~TraceSection() {
+        if (active_) {
+            ATrace_endSection();
+        }
+    }
+#else
+    explicit TraceSection(const char*) {}
+#endif
+
+    TraceSection(const TraceSection&) = delete;
+    TraceSection& operator=(const TraceSection&) = delete;
+
+#if QUESTCAMERA_TRACE
+private:
+    bool active_;
+#endif
+};
+
+// Calls a Unity callback inside a trace section and counts its duration
+template <typename Callback, typename... Args>
+inline void invokeCallback(const char* traceName, Callback callback, Args... args) {
+    TraceSection section(traceName);
+    StageTimer timer(Stage::Callback);
+    callback(args...);
+}
+
+} // namespace questcamera
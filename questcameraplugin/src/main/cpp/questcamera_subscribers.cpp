@@ -0,0 +1,382 @@
+/*
+ * Quest Camera Plugin for Unity - Frame subscriptions
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraSubscribers"
+
+#include "questcamera_subscribers.h"
+#include "questcamera_api.h"
+#include "questcamera_common.h"
+#include "questcamera_convert.h"
+#include "questcamera_pool.h"
+#include "questcamera_stats.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace questcamera {
+namespace {
+
+constexpr int kMaxSubscribers = QUESTCAMERA_MAX_SUBSCRIBERS;
+constexpr int kStereoEye = 2;
+constexpr int kEyeFormatCount = static_cast<int>(OutputFormat::Y8) + 1;
+constexpr size_t kSharedFramesPerThread = 8;
+constexpr int64_t kRateSlackNs = 2'000'000;  // Sensor timestamps jitter, see FrameGate
+
+// Copy of a derived frame for worker subscribers, recycled once every holder let go
+struct SharedFrame {
+    std::vector<uint8_t> data;
+    QuestCameraSubscribedFrame info = {};
+};
+using SharedFramePtr = std::shared_ptr<SharedFrame>;
+
+struct Subscriber {
+    // Config is written before active is set and only read after it was seen set
+    std::atomic<bool> active{false};
+    // Bumped when the slot is reused, so a frame thread that saw the previous subscription
+    // active never reads the new one's config, and stale ids are told apart
+    std::atomic<uint32_t> generation{0};
+    std::atomic<int> inFlight{0};  // Frame threads currently delivering to this slot
+    QuestCameraSubscription config = {};
+    int64_t minIntervalNs = 0;
+    std::atomic<int64_t> lastDeliveredNs[3] = {};  // Left, right, stereo
+    std::atomic<uint64_t> dropped{0};
+
+    // QUESTCAMERA_DELIVER_WORKER only
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    SharedFramePtr pending;
+    bool stopWorker = false;
+};
+
+Subscriber g_subscribers[kMaxSubscribers];
+std::atomic<int> g_subscriberCount{0};
+std::mutex g_subscribeMutex;  // Subscribe/unsubscribe, never taken on the frame path
+
+// Each producing thread recycles its own copies, so the pool needs no lock
+thread_local std::vector<SharedFramePtr> t_sharedFrames;
+thread_local PooledBuffer t_nv12Buffer;
+
+// Non-zero while this thread runs a subscriber callback. Inline ones still pin every due
+// subscriber and a worker cannot join itself, so subscribing or unsubscribing from there
+// could wait on the calling callback, directly or through another thread holding the mutex.
+thread_local int t_callbackDepth = 0;
+
+// Ids carry the slot's generation: (generation * kMaxSubscribers + index) + 1
+int32_t makeSubscriptionId(int index, uint32_t generation) {
+    const uint32_t idsPerSlot = static_cast<uint32_t>(INT32_MAX) / kMaxSubscribers;
+    return static_cast<int32_t>((generation % idsPerSlot) * kMaxSubscribers + index + 1);
+}
+
+// The subscriber the id was handed out for, or nullptr if the id is invalid or its slot
+// has been reused since
+Subscriber* findSubscriber(int32_t subscriptionId) {
+    if (subscriptionId < 1) {
+        return nullptr;
+    }
+    const int index = (subscriptionId - 1) % kMaxSubscribers;
+    Subscriber& sub = g_subscribers[index];
+    if (makeSubscriptionId(index, sub.generation.load()) != subscriptionId) {
+        return nullptr;
+    }
+    return &sub;
+}
+
+bool isDue(Subscriber& sub, int eye, int64_t timestamp) {
+    if (sub.minIntervalNs == 0) {
+        return true;
+    }
+    const int64_t last = sub.lastDeliveredNs[eye].load(std::memory_order_relaxed);
+    if (last != 0 && timestamp - last < sub.minIntervalNs - kRateSlackNs) {
+        return false;
+    }
+    sub.lastDeliveredNs[eye].store(timestamp, std::memory_order_relaxed);
+    return true;
+}
+
+// Collects the subscribers that take this frame and pins them until releaseDue
+int collectDue(int eye, int64_t timestamp, Subscriber** due, uint32_t* formatMask) {
+    const uint32_t eyeBit = eye == 0 ? QUESTCAMERA_EYE_LEFT : QUESTCAMERA_EYE_RIGHT;
+    int count = 0;
+    for (Subscriber& sub : g_subscribers) {
+        if (!sub.active.load(std::memory_order_acquire)) {
+            continue;
+        }
+        const uint32_t generation = sub.generation.load();
+        // Unsubscribe clears active before it waits for inFlight, so recheck after pinning.
+        // The generation catches the slot having been unsubscribed and reused in between,
+        // whose config may still have been written while this thread was not pinned yet.
+        sub.inFlight.fetch_add(1);
+        if (!sub.active.load() || sub.generation.load() != generation) {
+            sub.inFlight.fetch_sub(1);
+            continue;
+        }
+        const QuestCameraSubscription& config = sub.config;
+        const bool wants =
+            eye == kStereoEye ? config.format == QUESTCAMERA_FORMAT_STEREO_NV12
+                              : config.format != QUESTCAMERA_FORMAT_STEREO_NV12 && (config.eyes & eyeBit);
+        if (!wants || !isDue(sub, eye, timestamp)) {
+            sub.inFlight.fetch_sub(1);
+            continue;
+        }
+        due[count++] = &sub;
+        if (formatMask && eye != kStereoEye) {
+            *formatMask |= 1u << config.format;
+        }
+    }
+    return count;
+}
+
+void releaseDue(Subscriber* const* due, int count) {
+    for (int i = 0; i < count; ++i) {
+        due[i]->inFlight.fetch_sub(1);
+    }
+}
+
+SharedFramePtr shareFrame(const QuestCameraSubscribedFrame& frame) {
+    SharedFramePtr shared;
+    for (const SharedFramePtr& candidate : t_sharedFrames) {
+        // Only this thread hands out pool entries, so a count of 1 cannot grow under us
+        if (candidate.use_count() == 1) {
+            shared = candidate;
+            break;
+        }
+    }
+    if (!shared) {
+        shared = std::make_shared<SharedFrame>();
+        if (t_sharedFrames.size() < kSharedFramesPerThread) {
+            t_sharedFrames.push_back(shared);
+        }
+    }
+    shared->data.assign(frame.data, frame.data + frame.dataSize);
+    shared->info = frame;
+    shared->info.data = shared->data.data();
+    return shared;
+}
+
+void offer(Subscriber& sub, const SharedFramePtr& frame) {
+    {
+        std::lock_guard<std::mutex> lock(sub.mutex);
+        if (sub.pending) {
+            sub.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        sub.pending = frame;
+    }
+    sub.wake.notify_one();
+}
+
+// Inline subscribers get the frame right away, workers a shared copy made at most once
+void dispatch(Subscriber* const* due, int count, const QuestCameraSubscribedFrame& frame) {
+    SharedFramePtr shared;
+    for (int i = 0; i < count; ++i) {
+        Subscriber& sub = *due[i];
+        if (sub.config.format != frame.format) {
+            continue;
+        }
+        if (sub.config.delivery == QUESTCAMERA_DELIVER_INLINE) {
+            ++t_callbackDepth;
+            invokeCallback("QuestCamera subscriber callback", sub.config.callback, &frame,
+                           sub.config.userData);
+            --t_callbackDepth;
+        } else {
+            if (!shared) {
+                shared = shareFrame(frame);
+            }
+            offer(sub, shared);
+        }
+    }
+}
+
+void workerLoop(Subscriber* sub) {
+    t_callbackDepth = 1;  // The thread only exists to run callbacks
+    for (;;) {
+        SharedFramePtr frame;
+        {
+            std::unique_lock<std::mutex> lock(sub->mutex);
+            sub->wake.wait(lock, [sub] { return sub->pending || sub->stopWorker; });
+            if (sub->stopWorker) {
+                sub->pending.reset();
+                return;
+            }
+            frame = std::move(sub->pending);
+        }
+        invokeCallback("QuestCamera subscriber callback", sub->config.callback, &frame->info,
+                       sub->config.userData);
+    }
+}
+
+bool isValidSubscription(const QuestCameraSubscription& config) {
+    const bool stereo = config.format == QUESTCAMERA_FORMAT_STEREO_NV12;
+    const bool eyeFormat = config.format >= QUESTCAMERA_FORMAT_NV12 && config.format <= QUESTCAMERA_FORMAT_Y8;
+    const uint32_t eyeBits = QUESTCAMERA_EYE_LEFT | QUESTCAMERA_EYE_RIGHT;
+    return config.callback && (stereo || (eyeFormat && (config.eyes & eyeBits) != 0)) &&
+           config.maxHz >= 0.0f &&
+           (config.delivery == QUESTCAMERA_DELIVER_INLINE || config.delivery == QUESTCAMERA_DELIVER_WORKER);
+}
+
+} // namespace
+
+bool hasSubscribers() {
+    return g_subscriberCount.load(std::memory_order_relaxed) > 0;
+}
+
+void publishEyeFrame(bool isLeft, const FrameView& view) {
+    if (!hasSubscribers()) {
+        return;
+    }
+    const int eye = isLeft ? 0 : 1;
+    Subscriber* due[kMaxSubscribers];
+    uint32_t formatMask = 0;
+    const int count = collectDue(eye, view.timestamp, due, &formatMask);
+    if (count == 0) {
+        return;
+    }
+
+    TraceSection section("QuestCamera subscribers");
+    QuestCameraSubscribedFrame frame = {};
+    frame.width = view.width;
+    frame.height = view.height;
+    frame.eye = eye;
+    frame.sequence = view.sequence;
+    frame.timestamp = view.timestamp;
+    for (int format = 0; format < kEyeFormatCount; ++format) {
+        if ((formatMask & (1u << format)) == 0) {
+            continue;
+        }
+        if (format == QUESTCAMERA_FORMAT_NV12) {
+            frame.dataSize = view.width * view.height * 3 / 2;
+            if (isPackedNv12(view)) {
+                frame.data = view.yData;
+            } else {
+                uint8_t* packed = t_nv12Buffer.ensure(frame.dataSize);
+                packNv12(view, packed);
+                frame.data = packed;
+            }
+        } else {
+            // Per-thread buffer, consumed by dispatch before the next format overwrites it
+            frame.data = convertFrame(view, static_cast<OutputFormat>(format), &frame.dataSize);
+        }
+        frame.format = format;
+        dispatch(due, count, frame);
+    }
+    releaseDue(due, count);
+}
+
+void publishStereoFrame(const uint8_t* data, int32_t dataSize, int32_t width, int32_t height,
+                        uint64_t sequence, int64_t timestamp) {
+    if (!hasSubscribers()) {
+        return;
+    }
+    Subscriber* due[kMaxSubscribers];
+    const int count = collectDue(kStereoEye, timestamp, due, nullptr);
+    if (count == 0) {
+        return;
+    }
+
+    QuestCameraSubscribedFrame frame = {};
+    frame.data = data;
+    frame.dataSize = dataSize;
+    frame.width = width;
+    frame.height = height;
+    frame.format = QUESTCAMERA_FORMAT_STEREO_NV12;
+    frame.eye = kStereoEye;
+    frame.sequence = sequence;
+    frame.timestamp = timestamp;
+    dispatch(due, count, frame);
+    releaseDue(due, count);
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT int32_t QuestCamera_Subscribe(const QuestCameraSubscription* subscription) {
+    if (!subscription || !isValidSubscription(*subscription)) {
+        LOGE("Invalid subscription");
+        return 0;
+    }
+    if (t_callbackDepth > 0) {
+        LOGE("Cannot subscribe from a subscriber callback");
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(g_subscribeMutex);
+    for (int index = 0; index < kMaxSubscribers; ++index) {
+        Subscriber& sub = g_subscribers[index];
+        if (sub.active.load()) {
+            continue;
+        }
+        // Before the config is rewritten, see collectDue
+        const uint32_t generation = sub.generation.fetch_add(1) + 1;
+        sub.config = *subscription;
+        sub.minIntervalNs = subscription->maxHz > 0.0f
+            ? static_cast<int64_t>(1e9 / subscription->maxHz) : 0;
+        for (auto& last : sub.lastDeliveredNs) {
+            last.store(0, std::memory_order_relaxed);
+        }
+        sub.dropped.store(0, std::memory_order_relaxed);
+        sub.pending.reset();
+        sub.stopWorker = false;
+        if (subscription->delivery == QUESTCAMERA_DELIVER_WORKER) {
+            sub.worker = std::thread(workerLoop, &sub);
+        }
+        sub.active.store(true, std::memory_order_release);
+        g_subscriberCount.fetch_add(1, std::memory_order_relaxed);
+        const int32_t id = makeSubscriptionId(index, generation);
+        LOGD("Subscription %d: format %d, eyes %u, max %.1f Hz, %s", id, subscription->format,
+             subscription->eyes, subscription->maxHz,
+             subscription->delivery == QUESTCAMERA_DELIVER_WORKER ? "worker" : "inline");
+        return id;
+    }
+    LOGE("All %d subscription slots are taken", kMaxSubscribers);
+    return 0;
+}
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_Unsubscribe(int32_t subscriptionId) {
+    if (t_callbackDepth > 0) {
+        LOGE("Subscription %d cannot be removed from a subscriber callback", subscriptionId);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_subscribeMutex);
+    Subscriber* found = findSubscriber(subscriptionId);
+    if (!found || !found->active.load()) {
+        return;
+    }
+    Subscriber& sub = *found;
+    sub.active.store(false);
+    g_subscriberCount.fetch_sub(1, std::memory_order_relaxed);
+    // Inline callbacks run on the frame threads, wait for the ones already started
+    while (sub.inFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (sub.worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> workerLock(sub.mutex);
+            sub.stopWorker = true;
+        }
+        sub.wake.notify_one();
+        sub.worker.join();
+    }
+    LOGD("Subscription %d removed", subscriptionId);
+}
+
+extern "C" QUESTCAMERA_EXPORT uint64_t QuestCamera_GetSubscriberDrops(int32_t subscriptionId) {
+    const Subscriber* sub = findSubscriber(subscriptionId);
+    return sub ? sub->dropped.load(std::memory_order_relaxed) : 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * Quest Camera Plugin for Unity - Frame subscriptions
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+// One relaxed load, for the frame paths to skip the publish calls entirely
+bool hasSubscribers();
+
+// Hands one eye's frame to every due subscriber of that eye. Each requested format is
+// produced once (NV12 in place when the planes already are packed NV12) and shared.
+// Called from both capture paths and replay, next to the individual callbacks.
+void publishEyeFrame(bool isLeft, const FrameView& frame);
+
+// Hands a combined side-by-side NV12 pair to the stereo subscribers. data only has to
+// stay valid for the duration of the call.
+void publishStereoFrame(const uint8_t* data, int32_t dataSize, int32_t width, int32_t height,
+                        uint64_t sequence, int64_t timestamp);
+
+} // namespace questcamera
@@ -0,0 +1,131 @@
+/*
+ * Quest Camera Plugin for Unity - Capture thread affinity and priority
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraThread"
+
+#include "questcamera_thread.h"
+#include "questcamera_api.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+namespace questcamera {
+namespace {
+
+struct EyeThreadConfig {
+    std::mutex mutex;
+    ThreadConfig config;
+    std::atomic<uint32_t> generation{0};  // 0 means never configured
+};
+
+EyeThreadConfig g_eyeThreads[2];
+
+// Generation last applied by the calling thread, per eye
+thread_local uint32_t t_appliedGeneration[2] = {0, 0};
+
+} // namespace
+
+bool applyThreadConfig(const ThreadConfig& config) {
+    bool ok = true;
+    const pid_t tid = gettid();
+
+    // A zero mask resets to every CPU, so an earlier pin does not outlive the config
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    const long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        const bool selected = config.cpuMask == 0
+                                  ? cpu < cpuCount
+                                  : cpu < 64 && (config.cpuMask & (1ULL << cpu));
+        if (selected) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    if (sched_setaffinity(tid, sizeof(cpuSet), &cpuSet) != 0) {
+        LOGW("sched_setaffinity(0x%llx) failed: %s",
+             static_cast<unsigned long long>(config.cpuMask), strerror(errno));
+        ok = false;
+    }
+
+    if (config.realtimePriority > 0) {
+        sched_param param{};
+        param.sched_priority = config.realtimePriority;
+        if (sched_setscheduler(tid, SCHED_FIFO, &param) == 0) {
+            return ok;
+        }
+        // Usually EPERM for regular apps, fall back to nice below
+        LOGW("SCHED_FIFO priority %d refused: %s", config.realtimePriority, strerror(errno));
+        ok = false;
+    }
+    // Leave a realtime class from an earlier config, nice has no effect until then
+    if (sched_getscheduler(tid) != SCHED_OTHER) {
+        sched_param param{};
+        if (sched_setscheduler(tid, SCHED_OTHER, &param) != 0) {
+            LOGW("Returning to SCHED_OTHER failed: %s", strerror(errno));
+            ok = false;
+        }
+    }
+
+    if (setpriority(PRIO_PROCESS, tid, config.niceValue) != 0) {
+        LOGW("setpriority(%d) failed: %s", config.niceValue, strerror(errno));
+        ok = false;
+    }
+    return ok;
+}
+
+void setEyeThreadConfig(bool isLeft, const ThreadConfig& config) {
+    EyeThreadConfig& eye = g_eyeThreads[isLeft ? 0 : 1];
+    std::lock_guard<std::mutex> lock(eye.mutex);
+    eye.config = config;
+    eye.generation.fetch_add(1, std::memory_order_release);
+}
+
+void applyEyeThreadConfigIfChanged(bool isLeft) {
+    const int index = isLeft ? 0 : 1;
+    EyeThreadConfig& eye = g_eyeThreads[index];
+    const uint32_t generation = eye.generation.load(std::memory_order_acquire);
+    if (generation == t_appliedGeneration[index]) {
+        return;
+    }
+
+    ThreadConfig config;
+    {
+        std::lock_guard<std::mutex> lock(eye.mutex);
+        config = eye.config;
+    }
+    const bool ok = applyThreadConfig(config);
+    t_appliedGeneration[index] = generation;
+    LOGD("%s image thread %d: cpu mask 0x%llx, nice %d, rt %d (%s)",
+         isLeft ? "Left" : "Right", gettid(), static_cast<unsigned long long>(config.cpuMask),
+         config.niceValue, config.realtimePriority, ok ? "applied" : "partially applied");
+}
+
+} // namespace questcamera
+
+extern "C" QUESTCAMERA_EXPORT void QuestCamera_SetImageThreadConfig(bool isLeft, uint64_t cpuMask,
+                                                                    int32_t niceValue,
+                                                                    int32_t realtimePriority) {
+    questcamera::ThreadConfig config;
+    config.cpuMask = cpuMask;
+    config.niceValue = niceValue;
+    config.realtimePriority = realtimePriority;
+    questcamera::setEyeThreadConfig(isLeft, config);
+}
@@ -0,0 +1,40 @@
+/*
+ * Quest Camera Plugin for Unity - Capture thread affinity and priority
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+
+namespace questcamera {
+
+struct ThreadConfig {
+    uint64_t cpuMask = 0;          // Bit n = CPU n, 0 allows every CPU again
+    int32_t niceValue = 0;         // SCHED_OTHER nice, -20 (highest) .. 19
+    int32_t realtimePriority = 0;  // > 0 requests SCHED_FIFO at this priority instead, 0 returns to SCHED_OTHER
+};
+
+// Stores the config for one eye's image thread. It is applied by that thread
+// itself on its next frame, since affinity and priority are per thread.
+void setEyeThreadConfig(bool isLeft, const ThreadConfig& config);
+
+// Called at the top of every frame on the eye's capture thread. Costs one
+// relaxed load unless the config changed since this thread last applied it.
+void applyEyeThreadConfigIfChanged(bool isLeft);
+
+// Applies a config to the calling thread, returns false if any part was refused.
+bool applyThreadConfig(const ThreadConfig& config);
+
+} // namespace questcamera
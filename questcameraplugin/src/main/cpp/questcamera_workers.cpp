@@ -0,0 +1,209 @@
+/*
+ * Quest Camera Plugin for Unity - Banded frame processing workers
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "QuestCameraWorkers"
+
+#include "questcamera_workers.h"
+#include "questcamera_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace questcamera {
+namespace {
+
+constexpr int32_t kMaxWorkers = 8;
+// Both eyes, replay and the combiner can be banding at once; any beyond that run inline
+constexpr int kMaxJobs = 4;
+// A few bands per thread, so a worker that got preempted holds up less of the frame
+constexpr int32_t kBandsPerThread = 3;
+
+// One parallelFor call, on the caller's stack while it is published in g_jobs
+struct Job {
+    BandFunction function = nullptr;
+    const void* body = nullptr;
+    int32_t count = 0;
+    int32_t band = 0;
+    int32_t bands = 0;
+    std::atomic<int32_t> next{0};   // Next unclaimed band
+    std::atomic<int32_t> users{0};  // Workers still inside the job
+};
+
+struct Pool {
+    std::mutex mutex;  // Guards jobs and wakeups, held only to publish and pick up jobs
+    std::condition_variable wake;
+    Job* jobs[kMaxJobs] = {};
+    size_t nextJob = 0;  // Round-robin start, so both eyes' frames get workers
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
+
+// Never destroyed: the workers live until the process exits and must not be joined from a
+// static destructor
+Pool& g_pool = *new Pool();
+std::atomic<int32_t> g_workerCount{0};
+std::mutex g_configMutex;  // Serializes QuestCamera_SetWorkerThreads, never taken on the frame path
+
+thread_local bool t_insideBand = false;
+
+// Claims bands until none are left. Any thread may run any band: idle workers take
+// over whatever is left of another eye's frame.
+void drainJob(Job& job) {
+    const bool wasInside = t_insideBand;
+    t_insideBand = true;
+    for (;;) {
+        const int32_t index = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= job.bands) {
+            break;
+        }
+        const int32_t begin = index * job.band;
+        job.function(job.body, begin, std::min(job.count, begin + job.band));
+    }
+    t_insideBand = wasInside;
+}
+
+// Called with the pool mutex held
+Job* findJobLocked(Pool& pool) {
+    for (int i = 0; i < kMaxJobs; ++i) {
+        Job* job = pool.jobs[(pool.nextJob + i) % kMaxJobs];
+        if (job && job->next.load(std::memory_order_relaxed) < job->bands) {
+            pool.nextJob = (pool.nextJob + i + 1) % kMaxJobs;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void workerLoop(int32_t index, ThreadConfig config) {
+    applyThreadConfig(config);
+    LOGD("Worker %d started (cpu mask 0x%llx)", index, static_cast<unsigned long long>(config.cpuMask));
+    Pool& pool = g_pool;
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while (!pool.stopping) {
+        Job* job = findJobLocked(pool);
+        if (!job) {
+            pool.wake.wait(lock);
+            continue;
+        }
+        job->users.fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        drainJob(*job);
+        // Last touch of the job, its owner may return right after
+        job->users.fetch_sub(1, std::memory_order_release);
+        lock.lock();
+    }
+}
+
+void stopWorkers() {
+    Pool& pool = g_pool;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stopping = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread& thread : pool.threads) {
+        thread.join();
+    }
+    pool.threads.clear();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.stopping = false;
+}
+
+} // namespace
+
+void runBands(int32_t count, int32_t minBand, BandFunction function, const void* body) {
+    const int32_t workers = g_workerCount.load(std::memory_order_relaxed);
+    minBand = std::max(minBand, 1);
+    if (workers == 0 || t_insideBand || count < minBand * 2) {
+        function(body, 0, count);
+        return;
+    }
+
+    Job job;
+    job.function = function;
+    job.body = body;
+    job.count = count;
+    const int32_t targetBands = std::min((workers + 1) * kBandsPerThread, count / minBand);
+    job.band = (count + targetBands - 1) / targetBands;
+    job.bands = (count + job.band - 1) / job.band;
+
+    Pool& pool = g_pool;
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (int i = 0; i < kMaxJobs; ++i) {
+            if (!pool.jobs[i]) {
+                pool.jobs[i] = &job;
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        function(body, 0, count);
+        return;
+    }
+    pool.wake.notify_all();
+
+    drainJob(job);
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.jobs[slot] = nullptr;
+    }
+    // Every band is claimed; wait for the workers still running theirs
+    while (job.users.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+bool setWorkerThreads(int32_t count, const ThreadConfig& config) {
+    if (count < 0 || count > kMaxWorkers) {
+        LOGE("Worker count %d out of range (0..%d)", count, kMaxWorkers);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    // A frame already banding drains whatever bands the stopped workers leave behind
+    g_workerCount.store(0, std::memory_order_relaxed);
+    stopWorkers();
+
+    for (int32_t i = 0; i < count; ++i) {
+        g_pool.threads.emplace_back(workerLoop, i, config);
+    }
+    g_workerCount.store(count, std::memory_order_relaxed);
+    LOGD("Frame workers: %d, cpu mask 0x%llx, nice %d", count,
+         static_cast<unsigned long long>(config.cpuMask), config.niceValue);
+    return true;
+}
+
+} // namespace questcamera
+
+using namespace questcamera;
+
+extern "C" QUESTCAMERA_EXPORT bool QuestCamera_SetWorkerThreads(int32_t count, uint64_t cpuMask,
+                                                               int32_t niceValue) {
+    ThreadConfig config;
+    config.cpuMask = cpuMask;
+    config.niceValue = niceValue;
+    return setWorkerThreads(count, config);
+}
+
+extern "C" QUESTCAMERA_EXPORT int32_t QuestCamera_GetWorkerThreads(void) {
+    return g_workerCount.load(std::memory_order_relaxed);
+}
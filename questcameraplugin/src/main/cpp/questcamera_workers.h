@@ -0,0 +1,45 @@
+/*
+ * Quest Camera Plugin for Unity - Banded frame processing workers
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "questcamera_common.h"
+#include "questcamera_thread.h"
+
+namespace questcamera {
+
+// Replaces the worker threads with count new ones running with config (count 0 turns
+// banding off). Frames banding meanwhile finish their bands on their own thread.
+bool setWorkerThreads(int32_t count, const ThreadConfig& config);
+
+using BandFunction = void (*)(const void* body, int32_t begin, int32_t end);
+
+void runBands(int32_t count, int32_t minBand, BandFunction function, const void* body);
+
+// Calls body(begin, end) over [0, count) split into bands of at least minBand rows, on the
+// worker threads and the calling image thread, and returns once every band ran. Runs
+// body(0, count) inline while the pool is off, for small ranges and from inside a band.
+// Bands of one call may run concurrently, so body must only write its own rows.
+template <typename Body>
+inline void parallelFor(int32_t count, int32_t minBand, const Body& body) {
+    runBands(count, minBand,
+             [](const void* context, int32_t begin, int32_t end) {
+                 (*static_cast<const Body*>(context))(begin, end);
+             },
+             &body);
+}
+
+} // namespace questcamera
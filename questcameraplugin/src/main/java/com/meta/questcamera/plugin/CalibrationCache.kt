@@ -0,0 +1,136 @@
+/*
+ * Quest Camera Plugin for Unity - Calibration Cache
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.meta.questcamera.plugin
+
+import android.content.Context
+import android.os.Build
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.File
+import java.io.IOException
+
+/**
+ * Persists the result of camera discovery so later starts can skip walking every camera's
+ * characteristics. The file is tied to Build.FINGERPRINT, so an OS or firmware update (which
+ * may ship new factory calibration) invalidates it, as does a bump of VERSION.
+ */
+internal class CalibrationCache(context: Context) {
+    data class Entry(
+        val left: CameraInfo,
+        val right: CameraInfo,
+        val stereoLogicalCameraId: String?
+    )
+
+    private val file = File(context.filesDir, FILE_NAME)
+
+    fun load(): Entry? {
+        if (!file.exists()) return null
+        return try {
+            DataInputStream(file.inputStream().buffered()).use { input ->
+                if (input.readInt() != MAGIC || input.readInt() != VERSION) {
+                    QuestCameraLog.d(TAG) { "Calibration cache has an old layout, ignoring it" }
+                    return null
+                }
+                if (input.readUTF() != Build.FINGERPRINT) {
+                    QuestCameraLog.d(TAG) { "Calibration cache was written by another build, ignoring it" }
+                    return null
+                }
+                val left = readCameraInfo(input)
+                val right = readCameraInfo(input)
+                val logicalId = if (input.readBoolean()) input.readUTF() else null
+                Entry(left, right, logicalId)
+            }
+        } catch (e: IOException) {
+            QuestCameraLog.w(TAG) { "Failed to read calibration cache: ${e.message}" }
+            null
+        }
+    }
+
+    fun store(entry: Entry) {
+        // Written next to the real file and renamed, so a crash never leaves a torn cache
+        val temp = File(file.parentFile, "$FILE_NAME.tmp")
+        try {
+            DataOutputStream(temp.outputStream().buffered()).use { output ->
+                output.writeInt(MAGIC)
+                output.writeInt(VERSION)
+                output.writeUTF(Build.FINGERPRINT)
+                writeCameraInfo(output, entry.left)
+                writeCameraInfo(output, entry.right)
+                output.writeBoolean(entry.stereoLogicalCameraId != null)
+                entry.stereoLogicalCameraId?.let { output.writeUTF(it) }
+            }
+            if (!temp.renameTo(file)) {
+                QuestCameraLog.w(TAG) { "Failed to move calibration cache into place" }
+                temp.delete()
+            }
+        } catch (e: IOException) {
+            QuestCameraLog.w(TAG) { "Failed to write calibration cache: ${e.message}" }
+            temp.delete()
+        }
+    }
+
+    fun clear() {
+        file.delete()
+    }
+
+    private fun writeCameraInfo(output: DataOutputStream, info: CameraInfo) {
+        output.writeUTF(info.id)
+        output.writeInt(info.width)
+        output.writeInt(info.height)
+        output.writeInt(info.position.ordinal)
+        writeFloats(output, info.intrinsics)
+        writeFloats(output, info.distortion)
+        writeFloats(output, info.pose)
+        output.writeBoolean(info.isPassthrough)
+    }
+
+    private fun readCameraInfo(input: DataInputStream): CameraInfo {
+        val id = input.readUTF()
+        val width = input.readInt()
+        val height = input.readInt()
+        val position = Position.values().getOrElse(input.readInt()) { Position.Unknown }
+        return CameraInfo(
+            id = id,
+            width = width,
+            height = height,
+            position = position,
+            intrinsics = readFloats(input),
+            distortion = readFloats(input),
+            pose = readFloats(input),
+            isPassthrough = input.readBoolean()
+        )
+    }
+
+    private fun writeFloats(output: DataOutputStream, values: FloatArray) {
+        output.writeInt(values.size)
+        values.forEach { output.writeFloat(it) }
+    }
+
+    private fun readFloats(input: DataInputStream): FloatArray {
+        val size = input.readInt()
+        if (size < 0 || size > MAX_ARRAY_SIZE) throw IOException("Bad array size $size")
+        return FloatArray(size) { input.readFloat() }
+    }
+
+    companion object {
+        private const val TAG = "QuestCameraPlugin"
+        private const val FILE_NAME = "questcamera_calibration.bin"
+        private const val MAGIC = 0x51434331  // "QCC1"
+        private const val VERSION = 1
+        private const val MAX_ARRAY_SIZE = 64
+    }
+}
@@ -16,6 +16,8 @@
 
 package com.meta.questcamera.plugin
 
+import android.graphics.ImageFormat
+
 enum class Position {
     Left,
     Right,
@@ -59,6 +61,29 @@ data class CameraInfo(
         return true
     }
 
+    /**
+     * Same camera streamed at another resolution. Intrinsics are [fx, fy, cx, cy, s] in pixels of
+     * the pixel array; the result's are in pixels of the output image. Camera2 keeps the aspect
+     * ratio by taking the largest centered crop of the array that matches the output and scaling
+     * it uniformly, so every term scales by the same factor and the principal point also moves by
+     * the crop offset. Distortion and pose do not change.
+     */
+    fun scaledTo(outputWidth: Int, outputHeight: Int): CameraInfo {
+        if (outputWidth == width && outputHeight == height) return this
+        val scale = maxOf(outputWidth.toFloat() / width, outputHeight.toFloat() / height)
+        val cropX = (width - outputWidth / scale) / 2
+        val cropY = (height - outputHeight / scale) / 2
+        val scaled = intrinsics.copyOf()
+        if (scaled.size >= 5) {
+            scaled[0] *= scale
+            scaled[1] *= scale
+            scaled[2] = (scaled[2] - cropX) * scale
+            scaled[3] = (scaled[3] - cropY) * scale
+            scaled[4] *= scale
+        }
+        return copy(width = outputWidth, height = outputHeight, intrinsics = scaled)
+    }
+
     override fun hashCode(): Int {
         var result = id.hashCode()
         result = 31 * result + width
@@ -70,4 +95,25 @@ data class CameraInfo(
         result = 31 * result + isPassthrough.hashCode()
         return result
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Requested stream settings, validated against the camera's StreamConfigurationMap. A width or
+ * height of 0 keeps the sensor's pixel array size and an fps of 0 keeps the template's AE range.
+ */
+data class CaptureConfig(
+    val width: Int = 0,
+    val height: Int = 0,
+    val fps: Int = 0,
+    val format: Int = ImageFormat.YUV_420_888
+)
+
+/**
+ * Hardware encoded recording of each started eye to "<outputPrefix>_left.mp4" and
+ * "<outputPrefix>_right.mp4". A bitrate of 0 is derived from the frame size and rate.
+ */
+data class RecordingConfig(
+    val outputPrefix: String,
+    val hevc: Boolean = false,
+    val bitrate: Int = 0
+)
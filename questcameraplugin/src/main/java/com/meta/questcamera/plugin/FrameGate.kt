@@ -0,0 +1,82 @@
+/*
+ * Quest Camera Plugin for Unity - Frame decimation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.meta.questcamera.plugin
+
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Per-eye decimation for the ImageReader listener, the same rules as the native reader's
+ * gate in questcamera_capture.cpp. It runs right after acquireLatestImage, so a skipped
+ * frame is closed without being copied or crossing JNI. The settings may change from any
+ * thread, admit() is only called on the eye's image thread.
+ */
+internal class FrameGate {
+    @Volatile private var everyN = 1  // 1 = every frame, 0 = only captureNextFrame requests
+    @Volatile private var minIntervalNs = 0L
+    private val pendingCaptures = AtomicInteger()
+
+    private var skipped = 0
+    private var lastAdmittedNs = 0L
+
+    // Frames skipped between the last two admitted ones, for nativeRecordFrameTiming
+    var skippedBefore = 0
+        private set
+
+    fun configure(everyN: Int, minIntervalNs: Long) {
+        this.everyN = if (everyN < 0) 1 else everyN
+        this.minIntervalNs = minIntervalNs.coerceAtLeast(0)
+    }
+
+    fun requestNext() {
+        pendingCaptures.incrementAndGet()
+    }
+
+    // A pending capture request wins over decimation and is used up by the frame it admits
+    fun admit(timestampNs: Long): Boolean {
+        val admitted = if (pendingCaptures.get() > 0) {
+            // Only this thread decrements, so the count cannot go below zero
+            pendingCaptures.decrementAndGet()
+            true
+        } else {
+            val n = everyN
+            val interval = minIntervalNs
+            n > 0 && skipped + 1 >= n &&
+                (interval == 0L || lastAdmittedNs == 0L ||
+                    timestampNs - lastAdmittedNs >= interval - RATE_SLACK_NS)
+        }
+        if (!admitted) {
+            skipped++
+            return false
+        }
+        skippedBefore = skipped
+        skipped = 0
+        lastAdmittedNs = timestampNs
+        return true
+    }
+
+    // On reader creation, before any frame can reach admit()
+    fun resetProgress() {
+        skipped = 0
+        skippedBefore = 0
+        lastAdmittedNs = 0L
+    }
+
+    companion object {
+        // Sensor timestamps jitter by a few hundred microseconds
+        private const val RATE_SLACK_NS = 2_000_000L
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Quest Camera Plugin for Unity - Logging
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.meta.questcamera.plugin
+
+import android.os.SystemClock
+import android.util.Log
+
+/**
+ * Kotlin side of the plugin's logging. The minimum level comes from the native build
+ * (QUESTCAMERA_LOG_LEVEL in CMakeLists.txt), so both halves log at the same level. Messages
+ * are lambdas and are only built when their level is enabled.
+ */
+internal object QuestCameraLog {
+    // android.util.Log priorities, which match android_LogPriority on the native side
+    @Volatile
+    @JvmField
+    var minLevel = Log.DEBUG
+
+    inline fun d(tag: String, message: () -> String) {
+        if (minLevel <= Log.DEBUG) Log.d(tag, message())
+    }
+
+    inline fun i(tag: String, message: () -> String) {
+        if (minLevel <= Log.INFO) Log.i(tag, message())
+    }
+
+    inline fun w(tag: String, message: () -> String) {
+        if (minLevel <= Log.WARN) Log.w(tag, message())
+    }
+
+    inline fun e(tag: String, message: () -> String) {
+        if (minLevel <= Log.ERROR) Log.e(tag, message())
+    }
+}
+
+/**
+ * Lets one message per interval through, for logs on the frame path.
+ * Keep one instance per call site; it is safe to share between threads.
+ */
+internal class LogThrottle(private val intervalMs: Long) {
+    private var nextMs = 0L
+    private var suppressed = 0
+
+    inline fun d(tag: String, message: () -> String) {
+        if (QuestCameraLog.minLevel <= Log.DEBUG) log(Log.DEBUG, tag, message)
+    }
+
+    inline fun w(tag: String, message: () -> String) {
+        if (QuestCameraLog.minLevel <= Log.WARN) log(Log.WARN, tag, message)
+    }
+
+    inline fun e(tag: String, message: () -> String) {
+        if (QuestCameraLog.minLevel <= Log.ERROR) log(Log.ERROR, tag, message)
+    }
+
+    inline fun log(priority: Int, tag: String, message: () -> String) {
+        val skipped = acquire() ?: return
+        val text = if (skipped > 0) "${message()} ($skipped more suppressed)" else message()
+        Log.println(priority, tag, text)
+    }
+
+    // Number of calls swallowed since the last one that logged, or null to stay quiet
+    @Synchronized
+    fun acquire(): Int? {
+        val now = SystemClock.elapsedRealtime()
+        if (now < nextMs) {
+            suppressed++
+            return null
+        }
+        nextMs = now + intervalMs
+        val skipped = suppressed
+        suppressed = 0
+        return skipped
+    }
+}
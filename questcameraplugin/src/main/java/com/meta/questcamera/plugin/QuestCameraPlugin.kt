@@ -17,24 +17,38 @@
 package com.meta.questcamera.plugin
 
 import android.Manifest
+import android.annotation.SuppressLint
 import android.content.Context
 import android.graphics.ImageFormat
 import android.hardware.camera2.*
 import android.hardware.camera2.params.OutputConfiguration
 import android.hardware.camera2.params.SessionConfiguration
+import android.hardware.camera2.params.StreamConfigurationMap
 import android.media.Image
 import android.media.ImageReader
 import android.os.Handler
 import android.os.HandlerThread
 import android.os.SystemClock
-import android.util.Log
+import android.util.Range
+import android.util.Size
+import android.view.Surface
 import androidx.annotation.RequiresPermission
+import androidx.annotation.VisibleForTesting
+import java.nio.ByteBuffer
+import java.util.concurrent.Executor
 import java.util.concurrent.Executors
 
 class QuestCameraPlugin private constructor() {
     companion object {
         private const val TAG = "QuestCameraPlugin"
         private const val IMAGE_BUFFER_SIZE = 3
+        private const val FRAME_LOG_INTERVAL_MS = 5_000L
+        
+        // QUESTCAMERA_EYE_* and questcamera::StartupStage
+        private const val EYE_LEFT = 1
+        private const val EYE_RIGHT = 2
+        private const val STARTUP_STAGE_OPENED = 0
+        private const val STARTUP_STAGE_CONFIGURED = 1
         
         // Single instance with lazy initialization
         private val _instance: QuestCameraPlugin by lazy { QuestCameraPlugin() }
@@ -45,39 +59,117 @@ class QuestCameraPlugin private constructor() {
         // JNI Methods - called from C++
         @JvmStatic
         external fun onLeftFrameAvailable(
-            frameData: ByteArray,
+            frameData: ByteBuffer,
             width: Int, 
             height: Int,
-            timestamp: Long,
-            intrinsics: FloatArray,
-            distortion: FloatArray,
-            pose: FloatArray
+            timestamp: Long
         )
         
         @JvmStatic
         external fun onRightFrameAvailable(
-            frameData: ByteArray,
+            frameData: ByteBuffer,
             width: Int,
             height: Int, 
-            timestamp: Long,
+            timestamp: Long
+        )
+        
+        @JvmStatic
+        external fun onCameraError(errorMessage: String)
+        
+        // Calibration is pushed once per camera open and kept natively, frame calls omit it
+        @JvmStatic
+        external fun nativeSetCalibration(
+            isLeft: Boolean,
             intrinsics: FloatArray,
             distortion: FloatArray,
             pose: FloatArray
         )
         
+        // Compile-time minimum log level of the native library, QuestCameraLog follows it
         @JvmStatic
-        external fun onCameraError(errorMessage: String)
+        external fun nativeGetMinLogLevel(): Int
         
-        // NEW: Stereo frame callback
+        // Pipeline stats of the processImage path, QuestCamera_GetStats reads them
         @JvmStatic
-        external fun onStereoFrameAvailable(
-            frameData: ByteArray,
+        external fun nativeRecordFrameTiming(
+            isLeft: Boolean,
+            sensorTimestamp: Long,
+            acquireTime: Long,
+            decimatedBefore: Int
+        )
+        
+        // Native stereo combiner - each eye is written into the side-by-side buffer on arrival
+        @JvmStatic
+        external fun nativeSubmitStereoFrame(
+            isLeft: Boolean,
+            frameData: ByteBuffer,
             width: Int,
             height: Int,
-            timestamp: Long,
-            stereoMetadata: FloatArray
+            timestamp: Long
         )
         
+        @JvmStatic
+        external fun nativeClearStereoFrames()
+        
+        // Shared native buffer pool, processImage packs into a per-eye direct staging buffer from it
+        @JvmStatic
+        external fun nativeReserveBufferPool(width: Int, height: Int)
+        
+        @JvmStatic
+        external fun nativeAcquireStagingBuffer(isLeft: Boolean, size: Int): ByteBuffer?
+        
+        @JvmStatic
+        external fun nativeReleaseStagingBuffer(isLeft: Boolean)
+        
+        @JvmStatic
+        external fun nativeSetDeliveryFlags(individualCallbacks: Boolean, stereoCombining: Boolean)
+        
+        @JvmStatic
+        external fun nativeSetStereoSyncTolerance(toleranceNs: Long)
+        
+        @JvmStatic
+        external fun nativeSetFrameDecimation(isLeft: Boolean, everyN: Int, minIntervalNs: Long)
+        
+        @JvmStatic
+        external fun nativeCaptureNextFrame(isLeft: Boolean)
+        
+        // Bring-up timing, the native frame paths note each eye's first frame
+        @JvmStatic
+        external fun nativeBeginStartup(eyes: Int)
+        
+        @JvmStatic
+        external fun nativeMarkStartupStage(isLeft: Boolean, stage: Int)
+        
+        @JvmStatic
+        external fun nativeFailStartup()
+        
+        @JvmStatic
+        external fun nativeCancelStartup()
+        
+        @JvmStatic
+        external fun nativeResetFrameGaps()
+        
+        // One TotalCaptureResult's fields, read back with QuestCamera_GetFrameMetadata
+        @JvmStatic
+        external fun nativeRecordCaptureResult(
+            isLeft: Boolean,
+            sensorTimestamp: Long,
+            exposureTimeNs: Long,
+            frameDurationNs: Long,
+            sensitivity: Int,
+            rollingShutterSkewNs: Long
+        )
+        
+        // SENSOR_TIMESTAMP (boot time) -> the timestamp domain selected with QuestCamera_SetTimestampDomain,
+        // remembered per eye so QuestCamera_GetFrameMetadata can map the result back
+        @JvmStatic
+        external fun nativeStampFrame(isLeft: Boolean, sensorTimestamp: Long): Long
+        
+        // True if the V plane starts one byte after the U plane (NV12 order), only the native
+        // side can see the buffer addresses
+        @JvmStatic
+        external fun nativeIsUvInterleaved(uBuffer: ByteBuffer, vBuffer: ByteBuffer): Boolean
+        
         // JNI callback setters - called from Unity
         @JvmStatic
         external fun setLeftFrameCallback(callback: Long)
@@ -92,6 +184,40 @@ class QuestCameraPlugin private constructor() {
         @JvmStatic
         external fun setStereoFrameCallback(callback: Long)
         
+        // Plane callback setter, frames keep the camera's row and pixel strides (valid during the call)
+        @JvmStatic
+        external fun setStridedFrameCallback(callback: Long)
+        
+        // Luma pyramid / ROI crop callback setter, see QuestCamera_SetPyramidScale and QuestCamera_SetRoi
+        @JvmStatic
+        external fun setLumaOutputCallback(callback: Long)
+        
+        // Undistorted / stereo-rectified frame callback setter, see QuestCamera_SetRectification
+        @JvmStatic
+        external fun setRectifiedFrameCallback(callback: Long)
+        
+        // Zero-copy frame callback setter (native capture only), frames are returned
+        // with QuestCamera_ReleaseFrame
+        @JvmStatic
+        external fun setFrameHandleCallback(callback: Long)
+        
+        // GPU frame callback setter, AHardwareBuffer per frame (hardware buffer output only),
+        // frames are returned with QuestCamera_ReleaseFrame
+        @JvmStatic
+        external fun setHardwareBufferCallback(callback: Long)
+        
+        // Compact callbacks carry a sequence number and timestamp only, calibration is read
+        // once through QuestCamera_GetCalibration
+        @JvmStatic
+        external fun setCompactFrameCallback(callback: Long)
+        
+        @JvmStatic
+        external fun setCompactStereoFrameCallback(callback: Long)
+        
+        // Called once per camera start with the time to first frame of each eye, or on failure
+        @JvmStatic
+        external fun setStartupCallback(callback: Long)
+        
         // Camera control methods - called from Unity via JNI
         @JvmStatic
         external fun nativeInitialize(context: Context): Boolean
@@ -108,6 +234,57 @@ class QuestCameraPlugin private constructor() {
         @JvmStatic
         external fun nativeStopSingleCamera(isLeft: Boolean)
         
+        // Warm standby: sessions stay configured, only the repeating request is stopped or slowed
+        @JvmStatic
+        external fun nativePauseCapture(standbyFps: Int): Boolean
+        
+        @JvmStatic
+        external fun nativeResumeCapture(): Boolean
+        
+        // Native capture path - AImageReader owned by libquestcameraplugin
+        @JvmStatic
+        external fun nativeCreateImageReader(
+            isLeft: Boolean,
+            width: Int,
+            height: Int,
+            maxImages: Int,
+            format: Int,
+            hardwareBufferOutput: Boolean,
+            intrinsics: FloatArray,
+            distortion: FloatArray,
+            pose: FloatArray
+        ): Surface?
+        
+        @JvmStatic
+        external fun nativeDestroyImageReader(isLeft: Boolean)
+        
+        // AMediaCodec + AMediaMuxer recorder, returns the encoder's input surface
+        @JvmStatic
+        external fun nativeStartRecording(
+            isLeft: Boolean,
+            path: String,
+            width: Int,
+            height: Int,
+            fps: Int,
+            bitrate: Int,
+            hevc: Boolean
+        ): Surface?
+        
+        @JvmStatic
+        external fun nativeStopRecording(isLeft: Boolean)
+        
+        @JvmStatic
+        external fun nativeSetImageThreadConfig(isLeft: Boolean, cpuMask: Long, niceValue: Int, realtimePriority: Int)
+        
+        @JvmStatic
+        external fun nativeSetWorkerThreads(count: Int, cpuMask: Long, niceValue: Int): Boolean
+        
+        // Returns right away; both cameras are opened and configured in parallel and the startup
+        // callback reports when each eye delivered its first frame
+        @JvmStatic
+        @RequiresPermission(Manifest.permission.CAMERA)
+        fun startDualCameraAsync(): Boolean = getInstance().startDualCameraAsync()
+        
         // Optimized single camera start - automatically disables stereo features for maximum efficiency
         @JvmStatic
         @RequiresPermission(Manifest.permission.CAMERA)
@@ -120,127 +297,385 @@ class QuestCameraPlugin private constructor() {
         @JvmStatic
         fun setStereoCombiningEnabled(enabled: Boolean) {
             getInstance().enableStereoCombining = enabled
-            Log.d(TAG, "Stereo combining ${if (enabled) "enabled" else "disabled"}")
+            getInstance().syncNativeDeliveryFlags()
+            QuestCameraLog.d(TAG) { "Stereo combining ${if (enabled) "enabled" else "disabled"}" }
+        }
+        
+        // Maximum left/right timestamp difference of a stereo pair (default 5ms, <= 0 restores it)
+        @JvmStatic
+        fun setStereoSyncTolerance(toleranceNs: Long) {
+            nativeSetStereoSyncTolerance(toleranceNs)
+            QuestCameraLog.d(TAG) { "Stereo sync tolerance: $toleranceNs ns" }
+        }
+        
+        // Delivers every everyN-th frame of one eye (1 = all, 0 = only captureNextFrame) and at
+        // most maxHz frames per second (0 = no limit). Skipped frames are dropped right after
+        // acquire, before any copy or JNI call. Use the same settings on both eyes for stereo.
+        @JvmStatic
+        fun setFrameDecimation(isLeft: Boolean, everyN: Int, maxHz: Float) {
+            val minIntervalNs = if (maxHz > 0f) (1_000_000_000.0 / maxHz).toLong() else 0L
+            getInstance().frameGates[if (isLeft) 0 else 1].configure(everyN, minIntervalNs)
+            nativeSetFrameDecimation(isLeft, everyN, minIntervalNs)
+            QuestCameraLog.d(TAG) {
+                "${if (isLeft) "Left" else "Right"} decimation: every $everyN, max $maxHz Hz"
+            }
+        }
+        
+        // Delivers the next frame of one eye whatever the decimation, once per call
+        @JvmStatic
+        fun captureNextFrame(isLeft: Boolean) {
+            getInstance().frameGates[if (isLeft) 0 else 1].requestNext()
+            nativeCaptureNextFrame(isLeft)
         }
         
         @JvmStatic
         fun setIndividualCallbacksEnabled(enabled: Boolean) {
             getInstance().enableIndividualCallbacks = enabled
-            Log.d(TAG, "Individual callbacks ${if (enabled) "enabled" else "disabled"}")
+            getInstance().syncNativeDeliveryFlags()
+            QuestCameraLog.d(TAG) { "Individual callbacks ${if (enabled) "enabled" else "disabled"}" }
+        }
+        
+        // Frames are read by a native AImageReader and handed to the frame callbacks without
+        // touching the JVM. Takes effect on the next camera start; falls back to processImage
+        // if the native reader cannot be created.
+        @JvmStatic
+        fun setNativeCaptureEnabled(enabled: Boolean) {
+            getInstance().useNativeCapture = enabled
+            QuestCameraLog.d(TAG) { "Native capture ${if (enabled) "enabled" else "disabled"}" }
+        }
+        
+        // Frames are also allocated as GPU-sampleable AHardwareBuffers and handed to the hardware
+        // buffer callback, so Unity can import them as external textures. Implies native capture.
+        @JvmStatic
+        fun setHardwareBufferOutputEnabled(enabled: Boolean) {
+            getInstance().useHardwareBufferOutput = enabled
+            QuestCameraLog.d(TAG) { "Hardware buffer output ${if (enabled) "enabled" else "disabled"}" }
+        }
+        
+        // Records every started eye to "<outputPrefix>_left.mp4" / "_right.mp4" with the hardware
+        // encoder, fed by the camera directly. Takes effect on the next camera start, the files
+        // are finalized when the cameras stop. null disables it; bitrate 0 picks one from the size.
+        @JvmStatic
+        fun setRecordingEnabled(outputPrefix: String?, hevc: Boolean, bitrate: Int) {
+            getInstance().recordingConfig = outputPrefix?.takeIf { it.isNotEmpty() }?.let {
+                RecordingConfig(it, hevc, bitrate)
+            }
+            QuestCameraLog.d(TAG) { "Recording ${outputPrefix?.let { "to $it" } ?: "disabled"}" }
+        }
+        
+        // Drops the persisted discovery result, the next initialize() walks the cameras again
+        @JvmStatic
+        fun clearCalibrationCache() {
+            getInstance().calibrationCache?.clear()
+            QuestCameraLog.d(TAG) { "Calibration cache cleared" }
+        }
+        
+        // Pins one eye's image thread to the CPUs in cpuMask (0 = unchanged) and sets its nice
+        // value, or SCHED_FIFO if realtimePriority > 0 and permitted. Applied on the next frame.
+        @JvmStatic
+        fun setImageThreadConfig(isLeft: Boolean, cpuMask: Long, niceValue: Int, realtimePriority: Int) {
+            nativeSetImageThreadConfig(isLeft, cpuMask, niceValue, realtimePriority)
+            QuestCameraLog.d(TAG) {
+                "${if (isLeft) "Left" else "Right"} image thread config: " +
+                    "mask 0x${cpuMask.toString(16)}, nice $niceValue, rt $realtimePriority"
+            }
+        }
+        
+        // Splits the heavy per-frame stages into row bands across count native workers on
+        // the CPUs in cpuMask (0 = any); 0 workers keeps everything on the image threads
+        @JvmStatic
+        fun setWorkerThreads(count: Int, cpuMask: Long, niceValue: Int): Boolean {
+            val applied = nativeSetWorkerThreads(count, cpuMask, niceValue)
+            QuestCameraLog.d(TAG) {
+                "Frame workers: $count, mask 0x${cpuMask.toString(16)}, nice $niceValue (${if (applied) "applied" else "rejected"})"
+            }
+            return applied
         }
         
         @JvmStatic
         fun optimizeForSingleEye() {
             val instance = getInstance()
             instance.enableStereoCombining = false
+            instance.syncNativeDeliveryFlags()
             instance.stereoFrameCombiner.clear()
-            Log.d(TAG, "Optimized for single eye usage: stereo combining disabled")
+            QuestCameraLog.d(TAG) { "Optimized for single eye usage: stereo combining disabled" }
         }
         
         init {
             try {
                 System.loadLibrary("questcameraplugin")
-                Log.d(TAG, "Native library loaded successfully")
+                QuestCameraLog.minLevel = nativeGetMinLogLevel()
+                QuestCameraLog.d(TAG) { "Native library loaded successfully" }
             } catch (e: UnsatisfiedLinkError) {
-                Log.e(TAG, "Failed to load native library: ${e.message}")
+                QuestCameraLog.e(TAG) { "Failed to load native library: ${e.message}" }
             }
         }
     }
     
     private lateinit var context: Context
     private lateinit var cameraManager: CameraManager
+    private var calibrationCache: CalibrationCache? = null
     
     private var leftCamera: CameraDevice? = null
     private var rightCamera: CameraDevice? = null
     private var leftImageReader: ImageReader? = null
     private var rightImageReader: ImageReader? = null
+    // Pooled native buffers processImage packs into, only touched on the eye's image thread
+    private var leftStagingBuffer: ByteBuffer? = null
+    private var rightStagingBuffer: ByteBuffer? = null
+    // Whether the current reader's chroma is in NV12 order, from its first image (null until
+    // then). Only touched on the eye's image thread and cleared with the staging buffer.
+    private val uvInterleaved = arrayOfNulls<Boolean>(2)
+    private var leftNativeSurface: Surface? = null
+    private var rightNativeSurface: Surface? = null
+    // Encoder input surfaces, extra session outputs while recording
+    private var leftRecordingSurface: Surface? = null
+    private var rightRecordingSurface: Surface? = null
     private var leftSession: CameraCaptureSession? = null
     private var rightSession: CameraCaptureSession? = null
     
+    // Hardware-synced stereo: both physical passthrough cameras streamed by one logical
+    // camera and one session, so every request exposes the two sensors together
+    private var stereoLogicalCameraId: String? = null
+    private var syncedCamera: CameraDevice? = null
+    private var syncedSession: CameraCaptureSession? = null
+    private var syncedLeftSurface: Surface? = null
+    private var syncedRightSurface: Surface? = null
+    
     private val cameraThread = HandlerThread("CameraThread").apply { start() }
     private val cameraHandler = Handler(cameraThread.looper)
-    private val imageThread = HandlerThread("ImageThread").apply { start() }
-    private val imageHandler = Handler(imageThread.looper)
+    // Opening a device and configuring its session block the calling thread, so each eye
+    // gets a camera thread of its own and the two bring-ups overlap
+    private val leftCameraThread = HandlerThread("LeftCameraThread").apply { start() }
+    private val leftCameraHandler = Handler(leftCameraThread.looper)
+    private val rightCameraThread = HandlerThread("RightCameraThread").apply { start() }
+    private val rightCameraHandler = Handler(rightCameraThread.looper)
+    // One image thread per eye so left and right frames are processed in parallel
+    private val leftImageThread = HandlerThread("LeftImageThread").apply { start() }
+    private val leftImageHandler = Handler(leftImageThread.looper)
+    private val rightImageThread = HandlerThread("RightImageThread").apply { start() }
+    private val rightImageHandler = Handler(rightImageThread.looper)
     private val sessionExecutor = Executors.newSingleThreadExecutor()
     
     private var leftCameraInfo: CameraInfo? = null
     private var rightCameraInfo: CameraInfo? = null
     
-    private var isLeftCameraActive = false
-    private var isRightCameraActive = false
-    
-    // Timestamp conversion from boot time to global time
-    private val bootTimeOffset: Long by lazy {
-        System.currentTimeMillis() * 1_000_000L - SystemClock.elapsedRealtimeNanos()
-    }
+    // An eye's camera, session and active flag only change under its lock. The public start,
+    // stop, pause and resume calls take both, left first, and nothing holding the right lock
+    // takes the left one.
+    private val eyeStateLocks = arrayOf(Any(), Any())
+    @Volatile private var isLeftCameraActive = false
+    @Volatile private var isRightCameraActive = false
+    // Bumped by every stop. A start still queued or opening compares it in its callbacks
+    // and closes what it opened once it no longer matches.
+    @Volatile private var startGeneration = 0
     
     // NEW: Stereo frame combining - enabled by default
     private val stereoFrameCombiner = StereoFrameCombiner()
     private var enableStereoCombining = true  // Default to enabled
     private var enableIndividualCallbacks = true  // Whether to send individual left/right callbacks
+    private var useNativeCapture = false  // Bypass processImage with the native AImageReader path
+    private var useHardwareBufferOutput = false  // Native reader with GPU_SAMPLED_IMAGE usage
+    
+    // processImage runs for every frame, its logs are limited to one per eye every few seconds
+    private val frameLogThrottles = arrayOf(LogThrottle(FRAME_LOG_INTERVAL_MS), LogThrottle(FRAME_LOG_INTERVAL_MS))
+    private val errorLogThrottle = LogThrottle(FRAME_LOG_INTERVAL_MS)
+    
+    // Checked in the ImageReader listener, the native reader has its own copy of the settings
+    private val frameGates = arrayOf(FrameGate(), FrameGate())
     
-    // Convert camera timestamp (boot time) to global time
-    private fun convertToGlobalTime(bootTimeNanos: Long): Long {
-        return bootTimeNanos + bootTimeOffset
+    // Applied on the next camera start, see configure()
+    private var captureConfig = CaptureConfig()
+    private var captureFpsRange: Range<Int>? = null
+    private var recordingConfig: RecordingConfig? = null
+    
+    // Per-eye results are forwarded on the eye's camera thread; the synced session gets one
+    // result per request and splits it into the physical cameras' results
+    private val leftCaptureCallback = captureResultCallback(true)
+    private val rightCaptureCallback = captureResultCallback(false)
+    private val syncedCaptureCallback = object : CameraCaptureSession.CaptureCallback() {
+        @Suppress("DEPRECATION")  // physicalCameraTotalResults needs API 31, minSdk is 29
+        override fun onCaptureCompleted(session: CameraCaptureSession, request: CaptureRequest, result: TotalCaptureResult) {
+            val physicalResults = result.physicalCameraResults
+            leftCameraInfo?.let { recordCaptureResult(true, physicalResults[it.id] ?: result) }
+            rightCameraInfo?.let { recordCaptureResult(false, physicalResults[it.id] ?: result) }
+        }
+    }
+    
+    // Warm standby: sessions stay configured while paused, see pauseCapture()
+    private var isPaused = false
+    private var standbyFpsRange: Range<Int>? = null  // null while paused = no repeating request
+    private val sessionSurfaces = arrayOfNulls<List<Surface>>(2)  // Targets of each eye's request
+    
+    // The native capture path never reaches processImage, so it gets the same switches pushed down
+    private fun syncNativeDeliveryFlags() {
+        nativeSetDeliveryFlags(
+            enableIndividualCallbacks,
+            enableStereoCombining && isLeftCameraActive && isRightCameraActive
+        )
+    }
+    
+    private inline fun <T> withEyeState(isLeft: Boolean, block: () -> T): T =
+        synchronized(eyeStateLocks[if (isLeft) 0 else 1], block)
+    
+    private inline fun <T> withCameraState(block: () -> T): T =
+        synchronized(eyeStateLocks[0]) { synchronized(eyeStateLocks[1], block) }
+    
+    // A start of these eyes failed after it was issued, so they are no longer active. Ignored
+    // once stop ran, stop already cancelled the startup. Takes both locks, so never call it
+    // with only the right one held.
+    private fun failStartup(generation: Int, left: Boolean, right: Boolean) {
+        withCameraState {
+            if (generation != startGeneration) {
+                return
+            }
+            if (left) {
+                isLeftCameraActive = false
+            }
+            if (right) {
+                isRightCameraActive = false
+            }
+            syncNativeDeliveryFlags()
+            nativeFailStartup()
+        }
+    }
+    
+    // Convert a frame's camera timestamp (boot time) to the selected timestamp domain, global time
+    // by default. Once per delivered frame, the conversion is recorded for its capture result.
+    private fun convertToFrameTime(isLeft: Boolean, bootTimeNanos: Long): Long {
+        return nativeStampFrame(isLeft, bootTimeNanos)
     }
     
     // Called from JNI
     fun initialize(context: Context): Boolean {
-        Log.d(TAG, "Initializing QuestCameraPlugin")
+        QuestCameraLog.d(TAG) { "Initializing QuestCameraPlugin" }
         this.context = context
         this.cameraManager = context.getSystemService(Context.CAMERA_SERVICE) as CameraManager
-        return discoverCameras()
+        this.calibrationCache = CalibrationCache(context)
+        return loadCachedCameras() || discoverCameras()
     }
     
     // Called from JNI
     @RequiresPermission(Manifest.permission.CAMERA)
     fun startDualCamera(): Boolean {
-        Log.d(TAG, "Starting dual camera")
-        val leftInfo = leftCameraInfo ?: run {
-            Log.e(TAG, "Left camera info not available")
+        QuestCameraLog.d(TAG) { "Starting dual camera" }
+        val leftInfo = leftCameraInfo?.let { activeCameraInfo(it) } ?: run {
+            QuestCameraLog.e(TAG) { "Left camera info not available" }
+            return false
+        }
+        val rightInfo = rightCameraInfo?.let { activeCameraInfo(it) } ?: run {
+            QuestCameraLog.e(TAG) { "Right camera info not available" }
+            return false
+        }
+        
+        return withCameraState {
+            try {
+                isPaused = false
+                nativeBeginStartup(EYE_LEFT or EYE_RIGHT)
+                val generation = startGeneration
+                val logicalId = stereoLogicalCameraId
+                val success = if (logicalId != null) {
+                    openSyncedCameras(logicalId, leftInfo, rightInfo, generation)
+                } else {
+                    openCamera(leftInfo, true, generation) && openCamera(rightInfo, false, generation)
+                }
+                if (!success) {
+                    nativeFailStartup()
+                }
+                if (success) {
+                    // The opens finish on the camera threads, their failures clear these again
+                    isLeftCameraActive = true
+                    isRightCameraActive = true
+                    syncNativeDeliveryFlags()
+                }
+                success
+            } catch (e: Exception) {
+                QuestCameraLog.e(TAG) { "Failed to start cameras: ${e.message}" }
+                onCameraError("Failed to start cameras: ${e.message}")
+                false
+            }
+        }
+    }
+    
+    // Like startDualCamera, but returns once the work is queued: each eye's reader setup, open
+    // and session configuration run on its own camera thread. Completion and time to first
+    // frame come through the startup callback and QuestCamera_GetStartupTiming.
+    @RequiresPermission(Manifest.permission.CAMERA)
+    fun startDualCameraAsync(): Boolean {
+        QuestCameraLog.d(TAG) { "Starting dual camera asynchronously" }
+        val leftInfo = leftCameraInfo?.let { activeCameraInfo(it) } ?: run {
+            QuestCameraLog.e(TAG) { "Left camera info not available" }
             return false
         }
-        val rightInfo = rightCameraInfo ?: run {
-            Log.e(TAG, "Right camera info not available")
+        val rightInfo = rightCameraInfo?.let { activeCameraInfo(it) } ?: run {
+            QuestCameraLog.e(TAG) { "Right camera info not available" }
             return false
         }
         
-        return try {
-            val success = openCamera(leftInfo, true) && openCamera(rightInfo, false)
-            if (success) {
-                isLeftCameraActive = true
-                isRightCameraActive = true
+        // Active from here so pause and stop see the eyes; a failed open clears them again
+        val generation = withCameraState {
+            isPaused = false
+            nativeBeginStartup(EYE_LEFT or EYE_RIGHT)
+            isLeftCameraActive = true
+            isRightCameraActive = true
+            syncNativeDeliveryFlags()
+            startGeneration
+        }
+        
+        val logicalId = stereoLogicalCameraId
+        if (logicalId != null) {
+            // One device streams both eyes, there is nothing to overlap
+            cameraHandler.post {
+                if (!openSyncedCameras(logicalId, leftInfo, rightInfo, generation)) {
+                    failStartup(generation, true, true)
+                }
+            }
+        } else {
+            leftCameraHandler.post {
+                if (!openCamera(leftInfo, true, generation)) {
+                    failStartup(generation, true, false)
+                }
+            }
+            rightCameraHandler.post {
+                if (!openCamera(rightInfo, false, generation)) {
+                    failStartup(generation, false, true)
+                }
             }
-            success
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to start cameras: ${e.message}")
-            onCameraError("Failed to start cameras: ${e.message}")
-            false
         }
+        return true
     }
     
     // Called from JNI
     fun stopDualCamera() {
-        Log.d(TAG, "Stopping dual camera")
-        
-        leftSession?.stopRepeating()
-        rightSession?.stopRepeating()
-        leftSession?.close()
-        rightSession?.close()
-        leftCamera?.close()
-        rightCamera?.close()
-        leftImageReader?.close()
-        rightImageReader?.close()
-        
-        leftSession = null
-        rightSession = null
-        leftCamera = null
-        rightCamera = null
-        leftImageReader = null
-        rightImageReader = null
-        
-        isLeftCameraActive = false
-        isRightCameraActive = false
+        QuestCameraLog.d(TAG) { "Stopping dual camera" }
+        
+        withCameraState {
+            ++startGeneration
+            nativeCancelStartup()
+            isPaused = false
+            closeSyncedCameras()
+            leftSession?.stopRepeating()
+            rightSession?.stopRepeating()
+            leftSession?.close()
+            rightSession?.close()
+            leftCamera?.close()
+            rightCamera?.close()
+            closeImageReader(true)
+            closeImageReader(false)
+            releaseNativeReader(true)
+            releaseNativeReader(false)
+            stopRecorder(true)
+            stopRecorder(false)
+            
+            leftSession = null
+            rightSession = null
+            leftCamera = null
+            rightCamera = null
+            
+            isLeftCameraActive = false
+            isRightCameraActive = false
+            syncNativeDeliveryFlags()
+        }
         
         // NEW: Clear stereo combiner
         stereoFrameCombiner.clear()
@@ -249,73 +684,296 @@ class QuestCameraPlugin private constructor() {
     // Called from JNI
     @RequiresPermission(Manifest.permission.CAMERA)
     fun startSingleCamera(isLeft: Boolean): Boolean {
-        Log.d(TAG, "Starting ${if (isLeft) "left" else "right"} camera only")
+        QuestCameraLog.d(TAG) { "Starting ${if (isLeft) "left" else "right"} camera only" }
         
         val cameraInfo = if (isLeft) {
-            leftCameraInfo ?: run {
-                Log.e(TAG, "Left camera info not available")
+            leftCameraInfo?.let { activeCameraInfo(it) } ?: run {
+                QuestCameraLog.e(TAG) { "Left camera info not available" }
                 return false
             }
         } else {
-            rightCameraInfo ?: run {
-                Log.e(TAG, "Right camera info not available")
+            rightCameraInfo?.let { activeCameraInfo(it) } ?: run {
+                QuestCameraLog.e(TAG) { "Right camera info not available" }
                 return false
             }
         }
         
-        return try {
-            // Clear stereo combiner when starting single camera (optimization)
-            stereoFrameCombiner.clear()
+        return withCameraState {
+            try {
+                // Clear stereo combiner when starting single camera (optimization)
+                stereoFrameCombiner.clear()
+                nativeBeginStartup(if (isLeft) EYE_LEFT else EYE_RIGHT)
             
-            val success = openCamera(cameraInfo, isLeft)
-            if (success) {
-                if (isLeft) {
-                    isLeftCameraActive = true
+                val syncedSurface = if (isLeft) syncedLeftSurface else syncedRightSurface
+                val success = if (syncedSession != null && syncedSurface != null) {
+                    // The eye is still an output of the synced session, put it back into the request
+                    setSyncedRepeatingRequest(isLeft || isLeftCameraActive, !isLeft || isRightCameraActive)
+                    true
                 } else {
-                    isRightCameraActive = true
+                    openCamera(cameraInfo, isLeft, startGeneration)
                 }
+                if (!success) {
+                    nativeFailStartup()
+                }
+                if (success) {
+                    if (isLeft) {
+                        isLeftCameraActive = true
+                    } else {
+                        isRightCameraActive = true
+                    }
+                    syncNativeDeliveryFlags()
+                }
+                success
+            } catch (e: Exception) {
+                QuestCameraLog.e(TAG) { "Failed to start ${if (isLeft) "left" else "right"} camera: ${e.message}" }
+                onCameraError("Failed to start ${if (isLeft) "left" else "right"} camera: ${e.message}")
+                false
+            }
+        }
+    }
+    
+    // Called from JNI (QuestCamera_Configure). Checks the request against every passthrough
+    // camera and keeps it for the next start; running cameras are not restarted.
+    fun configure(width: Int, height: Int, fps: Int, format: Int): Boolean {
+        val config = CaptureConfig(width, height, fps, if (format == 0) ImageFormat.YUV_420_888 else format)
+        QuestCameraLog.d(TAG) { "Configure request: $config" }
+        
+        if (config.format != ImageFormat.YUV_420_888 &&
+            !(config.format == ImageFormat.PRIVATE && useHardwareBufferOutput)) {
+            // processImage and every CPU stage read NV12; PRIVATE frames only reach the GPU callback
+            QuestCameraLog.e(TAG) { "Unsupported capture format ${config.format}" }
+            return false
+        }
+        if ((config.width <= 0) != (config.height <= 0) || config.fps < 0) {
+            QuestCameraLog.e(TAG) { "Invalid capture config $config" }
+            return false
+        }
+        
+        val cameras = listOfNotNull(leftCameraInfo, rightCameraInfo)
+        if (cameras.isEmpty()) {
+            QuestCameraLog.e(TAG) { "No cameras discovered, call initialize first" }
+            return false
+        }
+        
+        var fpsRange: Range<Int>? = null
+        for (info in cameras) {
+            val characteristics = cameraManager.getCameraCharacteristics(info.id)
+            val map = characteristics.get(CameraCharacteristics.SCALER_STREAM_CONFIGURATION_MAP)
+            if (map == null) {
+                QuestCameraLog.e(TAG) { "Camera ${info.id} has no stream configuration map" }
+                return false
+            }
+            val size = if (config.width > 0) Size(config.width, config.height) else Size(info.width, info.height)
+            if (!isOutputSupported(map, config.format, size, config.fps)) {
+                QuestCameraLog.e(TAG) {
+                    "Camera ${info.id} does not support ${size.width}x${size.height} " +
+                        "format ${config.format} at ${config.fps} fps"
+                }
+                return false
+            }
+            if (config.fps > 0) {
+                val ranges = characteristics.get(CameraCharacteristics.CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES)
+                val range = selectFpsRange(ranges, config.fps) ?: run {
+                    QuestCameraLog.e(TAG) { "Camera ${info.id} has no AE target range for ${config.fps} fps" }
+                    return false
+                }
+                fpsRange = fpsRange ?: range
+            }
+        }
+        
+        captureConfig = config
+        captureFpsRange = fpsRange
+        if (isLeftCameraActive || isRightCameraActive) {
+            QuestCameraLog.d(TAG) { "Capture config stored, takes effect on the next camera start" }
+        }
+        return true
+    }
+    
+    private fun isOutputSupported(map: StreamConfigurationMap, format: Int, size: Size, fps: Int): Boolean {
+        val sizes = map.getOutputSizes(format) ?: return false
+        if (!sizes.contains(size)) return false
+        if (fps <= 0) return true
+        // 0 when the duration is unknown, accept it and let the AE range decide
+        val minFrameDurationNs = map.getOutputMinFrameDuration(format, size)
+        return minFrameDurationNs <= 1_000_000_000L / fps
+    }
+    
+    // Prefer a fixed [fps, fps] range so the sensor does not drop below the requested rate
+    private fun selectFpsRange(ranges: Array<Range<Int>>?, fps: Int): Range<Int>? {
+        ranges ?: return null
+        return ranges.firstOrNull { it.lower == fps && it.upper == fps }
+            ?: ranges.filter { it.upper == fps }.maxByOrNull { it.lower }
+    }
+    
+    private fun activeCameraInfo(info: CameraInfo): CameraInfo {
+        return if (captureConfig.width > 0) info.scaledTo(captureConfig.width, captureConfig.height) else info
+    }
+    
+    private fun applyCaptureSettings(builder: CaptureRequest.Builder) {
+        val fpsRange = if (isPaused) standbyFpsRange else captureFpsRange
+        fpsRange?.let { builder.set(CaptureRequest.CONTROL_AE_TARGET_FPS_RANGE, it) }
+    }
+    
+    // The slowest AE range that still reaches fps, preferring a fixed one, so standby keeps
+    // exposure and white balance converged at the lowest cost
+    private fun selectStandbyFpsRange(fps: Int): Range<Int>? {
+        var selected: Range<Int>? = null
+        for (info in listOfNotNull(leftCameraInfo, rightCameraInfo)) {
+            val ranges = cameraManager.getCameraCharacteristics(info.id)
+                .get(CameraCharacteristics.CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES) ?: return null
+            val range = ranges.filter { it.upper >= fps }
+                .minWithOrNull(compareBy<Range<Int>>({ it.upper }, { -it.lower })) ?: return null
+            if (selected == null || range.upper > selected.upper) {
+                selected = range
+            }
+        }
+        return selected
+    }
+    
+    // Called from JNI. Keeps devices, sessions and readers configured and only replaces the
+    // repeating request: stopped with standbyFps 0, otherwise the slowest AE range at or above
+    // standbyFps. Frames still captured in standby are delivered as usual.
+    fun pauseCapture(standbyFps: Int): Boolean {
+        return withCameraState {
+            if (!isLeftCameraActive && !isRightCameraActive) {
+                QuestCameraLog.w(TAG) { "No camera is active, nothing to pause" }
+                return false
+            }
+            val range = if (standbyFps > 0) selectStandbyFpsRange(standbyFps) else null
+            if (standbyFps > 0 && range == null) {
+                QuestCameraLog.w(TAG) { "No AE range reaches $standbyFps fps, stopping the request instead" }
+            }
+            isPaused = true
+            standbyFpsRange = range
+            try {
+                applyRepeatingRequests()
+                nativeClearStereoFrames()
+                // The sensor interval changes, gaps around it are not drops
+                nativeResetFrameGaps()
+                QuestCameraLog.d(TAG) { "Capture paused${range?.let { " at $it fps" } ?: ""}" }
+                true
+            } catch (e: Exception) {
+                QuestCameraLog.e(TAG) { "Failed to pause capture: ${e.message}" }
+                false
+            }
+        }
+    }
+    
+    // Called from JNI. Restores the normal repeating request on the standby sessions; the first
+    // frames are timed like a start and reported through the startup callback.
+    fun resumeCapture(): Boolean {
+        return withCameraState {
+            if (!isPaused) {
+                return isLeftCameraActive || isRightCameraActive
+            }
+            isPaused = false
+            standbyFpsRange = null
+            nativeBeginStartup((if (isLeftCameraActive) EYE_LEFT else 0) or (if (isRightCameraActive) EYE_RIGHT else 0))
+            try {
+                applyRepeatingRequests()
+                QuestCameraLog.d(TAG) { "Capture resumed" }
+                true
+            } catch (e: Exception) {
+                QuestCameraLog.e(TAG) { "Failed to resume capture: ${e.message}" }
+                onCameraError("Failed to resume capture: ${e.message}")
+                nativeFailStartup()
+                false
+            }
+        }
+    }
+    
+    // Re-issues every active eye's repeating request for the current pause state
+    private fun applyRepeatingRequests() {
+        if (syncedSession != null) {
+            if (isPaused && standbyFpsRange == null) {
+                syncedSession?.stopRepeating()
+            } else {
+                setSyncedRepeatingRequest(isLeftCameraActive, isRightCameraActive)
+            }
+            return
+        }
+        for (isLeft in booleanArrayOf(true, false)) {
+            if (!(if (isLeft) isLeftCameraActive else isRightCameraActive)) {
+                continue
+            }
+            // Still opening: onConfigured starts the request in the current pause state
+            val session = (if (isLeft) leftSession else rightSession) ?: continue
+            val camera = (if (isLeft) leftCamera else rightCamera) ?: continue
+            val surfaces = sessionSurfaces[if (isLeft) 0 else 1] ?: continue
+            if (isPaused && standbyFpsRange == null) {
+                session.stopRepeating()
+            } else {
+                startRepeatingRequest(camera, surfaces, isLeft)
             }
-            success
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to start ${if (isLeft) "left" else "right"} camera: ${e.message}")
-            onCameraError("Failed to start ${if (isLeft) "left" else "right"} camera: ${e.message}")
-            false
         }
     }
     
     // Called from JNI
     fun stopSingleCamera(isLeft: Boolean) {
-        Log.d(TAG, "Stopping ${if (isLeft) "left" else "right"} camera")
+        QuestCameraLog.d(TAG) { "Stopping ${if (isLeft) "left" else "right"} camera" }
         
-        if (isLeft && isLeftCameraActive) {
-            leftSession?.stopRepeating()
-            leftSession?.close()
-            leftCamera?.close()
-            leftImageReader?.close()
+        withCameraState {
+            ++startGeneration
+            nativeCancelStartup()
+            if (syncedSession != null || syncedCamera != null) {
+                stopSyncedEye(isLeft)
+            } else if (isLeft && isLeftCameraActive) {
+                leftSession?.stopRepeating()
+                leftSession?.close()
+                leftCamera?.close()
+                closeImageReader(true)
+                releaseNativeReader(true)
+                stopRecorder(true)
             
-            leftSession = null
-            leftCamera = null
-            leftImageReader = null
-            isLeftCameraActive = false
-            Log.d(TAG, "Left camera stopped")
-        } else if (!isLeft && isRightCameraActive) {
-            rightSession?.stopRepeating()
-            rightSession?.close()
-            rightCamera?.close()
-            rightImageReader?.close()
+                leftSession = null
+                leftCamera = null
+                isLeftCameraActive = false
+                syncNativeDeliveryFlags()
+                QuestCameraLog.d(TAG) { "Left camera stopped" }
+            } else if (!isLeft && isRightCameraActive) {
+                rightSession?.stopRepeating()
+                rightSession?.close()
+                rightCamera?.close()
+                closeImageReader(false)
+                releaseNativeReader(false)
+                stopRecorder(false)
             
-            rightSession = null
-            rightCamera = null
-            rightImageReader = null
-            isRightCameraActive = false
-            Log.d(TAG, "Right camera stopped")
-        } else {
-            Log.w(TAG, "${if (isLeft) "Left" else "Right"} camera is not active, nothing to stop")
+                rightSession = null
+                rightCamera = null
+                isRightCameraActive = false
+                syncNativeDeliveryFlags()
+                QuestCameraLog.d(TAG) { "Right camera stopped" }
+            } else {
+                QuestCameraLog.w(TAG) { "${if (isLeft) "Left" else "Right"} camera is not active, nothing to stop" }
+            }
+            if (!isLeftCameraActive && !isRightCameraActive) {
+                isPaused = false
+            }
+        }
+    }
+    
+    // Discovery result from a previous run of the same build, if its cameras still exist
+    private fun loadCachedCameras(): Boolean {
+        val entry = calibrationCache?.load() ?: return false
+        val ids = try {
+            cameraManager.cameraIdList.toSet()
+        } catch (e: Exception) {
+            return false
+        }
+        val logicalId = entry.stereoLogicalCameraId
+        if (entry.left.id !in ids || entry.right.id !in ids || (logicalId != null && logicalId !in ids)) {
+            QuestCameraLog.d(TAG) { "Cached cameras are no longer present, rediscovering" }
+            return false
         }
+        leftCameraInfo = entry.left
+        rightCameraInfo = entry.right
+        stereoLogicalCameraId = logicalId
+        QuestCameraLog.d(TAG) { "Loaded cameras from calibration cache: ${entry.left.id} + ${entry.right.id}" }
+        return true
     }
     
     private fun discoverCameras(): Boolean {
-        Log.d(TAG, "Discovering cameras")
+        QuestCameraLog.d(TAG) { "Discovering cameras" }
         try {
             cameraManager.cameraIdList.forEach { cameraId ->
                 val characteristics = cameraManager.getCameraCharacteristics(cameraId)
@@ -351,33 +1009,370 @@ class QuestCameraPlugin private constructor() {
                     when (Position.fromInt(position)) {
                         Position.Left -> {
                             leftCameraInfo = cameraInfo
-                            Log.d(TAG, "Found left camera: $cameraId (${pixelSize.width}x${pixelSize.height})")
+                            QuestCameraLog.d(TAG) { "Found left camera: $cameraId (${pixelSize.width}x${pixelSize.height})" }
                         }
                         Position.Right -> {
                             rightCameraInfo = cameraInfo
-                            Log.d(TAG, "Found right camera: $cameraId (${pixelSize.width}x${pixelSize.height})")
+                            QuestCameraLog.d(TAG) { "Found right camera: $cameraId (${pixelSize.width}x${pixelSize.height})" }
                         }
                         Position.Unknown -> {
-                            Log.w(TAG, "Unknown camera position for $cameraId")
+                            QuestCameraLog.w(TAG) { "Unknown camera position for $cameraId" }
                         }
                     }
                 }
             }
             
             val bothFound = leftCameraInfo != null && rightCameraInfo != null
-            Log.d(TAG, "Camera discovery complete. Both cameras found: $bothFound")
+            if (bothFound) {
+                stereoLogicalCameraId = findStereoLogicalCamera(leftCameraInfo!!.id, rightCameraInfo!!.id)
+            }
+            QuestCameraLog.d(TAG) { "Camera discovery complete. Both cameras found: $bothFound" }
+            if (bothFound) {
+                calibrationCache?.store(
+                    CalibrationCache.Entry(leftCameraInfo!!, rightCameraInfo!!, stereoLogicalCameraId)
+                )
+            }
             return bothFound
         } catch (e: Exception) {
-            Log.e(TAG, "Camera discovery failed: ${e.message}")
+            QuestCameraLog.e(TAG) { "Camera discovery failed: ${e.message}" }
             onCameraError("Camera discovery failed: ${e.message}")
             return false
         }
     }
     
+    // Logical multi-camera whose physical cameras include both passthrough cameras, if any
+    private fun findStereoLogicalCamera(leftId: String, rightId: String): String? {
+        for (cameraId in cameraManager.cameraIdList) {
+            val characteristics = cameraManager.getCameraCharacteristics(cameraId)
+            val capabilities = characteristics.get(CameraCharacteristics.REQUEST_AVAILABLE_CAPABILITIES)
+                ?: continue
+            if (!capabilities.contains(CameraMetadata.REQUEST_AVAILABLE_CAPABILITIES_LOGICAL_MULTI_CAMERA)) {
+                continue
+            }
+            val physicalIds = characteristics.physicalCameraIds
+            if (physicalIds.contains(leftId) && physicalIds.contains(rightId)) {
+                val syncType = characteristics.get(CameraCharacteristics.LOGICAL_MULTI_CAMERA_SENSOR_SYNC_TYPE)
+                val syncName = if (syncType == CameraMetadata.LOGICAL_MULTI_CAMERA_SENSOR_SYNC_TYPE_CALIBRATED) {
+                    "calibrated"
+                } else {
+                    "approximate"
+                }
+                QuestCameraLog.d(TAG) { "Found stereo logical camera $cameraId ($leftId + $rightId, $syncName sync)" }
+                return cameraId
+            }
+        }
+        QuestCameraLog.d(TAG) { "No logical multi-camera covers both passthrough cameras, using independent sessions" }
+        return null
+    }
+    
+    // generation is the startGeneration the start was issued in, a stop since then aborts it
     @RequiresPermission(Manifest.permission.CAMERA)
-    private fun openCamera(cameraInfo: CameraInfo, isLeft: Boolean): Boolean {
-        Log.d(TAG, "Opening ${if (isLeft) "left" else "right"} camera: ${cameraInfo.id}")
+    private fun openSyncedCameras(
+        logicalId: String,
+        leftInfo: CameraInfo,
+        rightInfo: CameraInfo,
+        generation: Int
+    ): Boolean = withCameraState {
+        if (generation != startGeneration) {
+            QuestCameraLog.d(TAG) { "Cameras stopped before the synced open ran" }
+            return false
+        }
+        QuestCameraLog.d(TAG) { "Opening synced stereo cameras through logical camera $logicalId" }
+        nativeReserveBufferPool(leftInfo.width, leftInfo.height)
+        nativeSetCalibration(true, leftInfo.intrinsics, leftInfo.distortion, leftInfo.pose)
+        nativeSetCalibration(false, rightInfo.intrinsics, rightInfo.distortion, rightInfo.pose)
+        
+        val leftSurface = (if (useNativeCapture || useHardwareBufferOutput) createNativeReader(leftInfo, true) else null)
+            ?: createImageReader(leftInfo, true).surface
+        val rightSurface = (if (useNativeCapture || useHardwareBufferOutput) createNativeReader(rightInfo, false) else null)
+            ?: createImageReader(rightInfo, false).surface
+        syncedLeftSurface = leftSurface
+        syncedRightSurface = rightSurface
+        startRecorder(leftInfo, true)
+        startRecorder(rightInfo, false)
         
+        try {
+            cameraManager.openCamera(logicalId, object : CameraDevice.StateCallback() {
+                override fun onOpened(camera: CameraDevice) {
+                    withCameraState {
+                        if (generation != startGeneration) {
+                            QuestCameraLog.d(TAG) { "Logical stereo camera opened after stop, closing it" }
+                            camera.close()
+                            return
+                        }
+                        QuestCameraLog.d(TAG) { "Logical stereo camera opened: $logicalId" }
+                        nativeMarkStartupStage(true, STARTUP_STAGE_OPENED)
+                        nativeMarkStartupStage(false, STARTUP_STAGE_OPENED)
+                        syncedCamera = camera
+                        createSyncedCaptureSession(camera, leftInfo, rightInfo, generation)
+                    }
+                }
+                
+                override fun onDisconnected(camera: CameraDevice) {
+                    QuestCameraLog.w(TAG) { "Logical stereo camera $logicalId disconnected" }
+                    withCameraState {
+                        camera.close()
+                        if (syncedCamera === camera) {
+                            syncedCamera = null
+                        }
+                    }
+                    failStartup(generation, true, true)
+                }
+                
+                override fun onError(camera: CameraDevice, error: Int) {
+                    val errorMsg = "Logical stereo camera $logicalId error: $error"
+                    QuestCameraLog.e(TAG) { errorMsg }
+                    onCameraError(errorMsg)
+                    withCameraState {
+                        camera.close()
+                        if (syncedCamera === camera) {
+                            syncedCamera = null
+                        }
+                    }
+                    failStartup(generation, true, true)
+                }
+            }, cameraHandler)
+            true
+        } catch (e: Exception) {
+            QuestCameraLog.w(TAG) { "Failed to open logical stereo camera $logicalId: ${e.message}" }
+            closeSyncedCameras()
+            openCamera(leftInfo, true, generation) && openCamera(rightInfo, false, generation)
+        }
+    }
+    
+    @SuppressLint("MissingPermission")  // Only reached from startDualCamera
+    private fun createSyncedCaptureSession(
+        camera: CameraDevice,
+        leftInfo: CameraInfo,
+        rightInfo: CameraInfo,
+        generation: Int
+    ) {
+        val leftSurface = syncedLeftSurface ?: return
+        val rightSurface = syncedRightSurface ?: return
+        
+        val outputConfigs = listOfNotNull(
+            OutputConfiguration(leftSurface).apply { setPhysicalCameraId(leftInfo.id) },
+            OutputConfiguration(rightSurface).apply { setPhysicalCameraId(rightInfo.id) },
+            leftRecordingSurface?.let { OutputConfiguration(it).apply { setPhysicalCameraId(leftInfo.id) } },
+            rightRecordingSurface?.let { OutputConfiguration(it).apply { setPhysicalCameraId(rightInfo.id) } }
+        )
+        val sessionConfig = SessionConfiguration(
+            SessionConfiguration.SESSION_REGULAR,
+            outputConfigs,
+            sessionExecutor,
+            object : CameraCaptureSession.StateCallback() {
+                override fun onConfigured(session: CameraCaptureSession) {
+                    withCameraState {
+                        if (generation != startGeneration) {
+                            QuestCameraLog.d(TAG) { "Synced stereo session configured after stop, closing it" }
+                            session.close()
+                            return
+                        }
+                        QuestCameraLog.d(TAG) { "Synced stereo capture session configured" }
+                        syncedSession = session
+                        setSyncedRepeatingRequest(true, true)
+                        nativeMarkStartupStage(true, STARTUP_STAGE_CONFIGURED)
+                        nativeMarkStartupStage(false, STARTUP_STAGE_CONFIGURED)
+                    }
+                }
+                
+                override fun onConfigureFailed(session: CameraCaptureSession) {
+                    // Not every logical camera can stream two physical outputs, use two sessions instead
+                    QuestCameraLog.w(TAG) { "Synced stereo session not supported, falling back to independent sessions" }
+                    cameraHandler.post {
+                        val started = withCameraState {
+                            if (generation != startGeneration) {
+                                return@post
+                            }
+                            closeSyncedCameras()
+                            stereoLogicalCameraId = null
+                            openCamera(leftInfo, true, generation) && openCamera(rightInfo, false, generation)
+                        }
+                        if (!started) {
+                            onCameraError("Failed to start cameras after synced session fallback")
+                            failStartup(generation, true, true)
+                        }
+                    }
+                }
+            }
+        )
+        
+        camera.createCaptureSession(sessionConfig)
+    }
+    
+    // One request targets both outputs, so both sensors capture for the same frame
+    private fun setSyncedRepeatingRequest(left: Boolean, right: Boolean) {
+        val camera = syncedCamera ?: return
+        val session = syncedSession ?: return
+        
+        val captureRequest = camera.createCaptureRequest(CameraDevice.TEMPLATE_PREVIEW).apply {
+            if (left) {
+                syncedLeftSurface?.let { addTarget(it) }
+                leftRecordingSurface?.let { addTarget(it) }
+            }
+            if (right) {
+                syncedRightSurface?.let { addTarget(it) }
+                rightRecordingSurface?.let { addTarget(it) }
+            }
+            applyCaptureSettings(this)
+        }
+        session.setRepeatingRequest(captureRequest.build(), syncedCaptureCallback, cameraHandler)
+    }
+    
+    // The outputs belong to one session, so one eye is stopped by leaving it out of the request
+    private fun stopSyncedEye(isLeft: Boolean) {
+        if (isLeft) {
+            isLeftCameraActive = false
+        } else {
+            isRightCameraActive = false
+        }
+        syncNativeDeliveryFlags()
+        
+        if (!isLeftCameraActive && !isRightCameraActive) {
+            closeSyncedCameras()
+        } else {
+            setSyncedRepeatingRequest(isLeftCameraActive, isRightCameraActive)
+        }
+        QuestCameraLog.d(TAG) { "${if (isLeft) "Left" else "Right"} synced camera stopped" }
+    }
+    
+    private fun closeSyncedCameras() {
+        syncedSession?.stopRepeating()
+        syncedSession?.close()
+        syncedCamera?.close()
+        if (syncedLeftSurface != null) {
+            closeImageReader(true)
+            releaseNativeReader(true)
+        }
+        if (syncedRightSurface != null) {
+            closeImageReader(false)
+            releaseNativeReader(false)
+        }
+        stopRecorder(true)
+        stopRecorder(false)
+        
+        syncedSession = null
+        syncedCamera = null
+        syncedLeftSurface = null
+        syncedRightSurface = null
+    }
+    
+    // generation is the startGeneration the start was issued in, a stop since then aborts it
+    @RequiresPermission(Manifest.permission.CAMERA)
+    private fun openCamera(cameraInfo: CameraInfo, isLeft: Boolean, generation: Int): Boolean {
+        // Reported once the eye lock is released, the error callback may stop the cameras
+        val failure = withEyeState(isLeft) {
+            if (generation != startGeneration) {
+                QuestCameraLog.d(TAG) { "Cameras stopped before the ${if (isLeft) "left" else "right"} open ran" }
+                return false
+            }
+            QuestCameraLog.d(TAG) { "Opening ${if (isLeft) "left" else "right"} camera: ${cameraInfo.id}" }
+            nativeReserveBufferPool(cameraInfo.width, cameraInfo.height)
+            nativeSetCalibration(isLeft, cameraInfo.intrinsics, cameraInfo.distortion, cameraInfo.pose)
+            
+            val outputSurface = (if (useNativeCapture || useHardwareBufferOutput) createNativeReader(cameraInfo, isLeft) else null)
+                ?: createImageReader(cameraInfo, isLeft).surface
+            val recordingSurface = startRecorder(cameraInfo, isLeft)
+            
+            try {
+                cameraManager.openCamera(cameraInfo.id, object : CameraDevice.StateCallback() {
+                    override fun onOpened(camera: CameraDevice) {
+                        withEyeState(isLeft) {
+                            if (generation != startGeneration) {
+                                QuestCameraLog.d(TAG) { "Camera ${cameraInfo.id} opened after stop, closing it" }
+                                camera.close()
+                                return
+                            }
+                            QuestCameraLog.d(TAG) { "${if (isLeft) "Left" else "Right"} camera opened: ${cameraInfo.id}" }
+                            nativeMarkStartupStage(isLeft, STARTUP_STAGE_OPENED)
+                            if (isLeft) {
+                                leftCamera = camera
+                            } else {
+                                rightCamera = camera
+                            }
+                            createCaptureSession(camera, listOfNotNull(outputSurface, recordingSurface), isLeft, generation)
+                        }
+                    }
+                    
+                    override fun onDisconnected(camera: CameraDevice) {
+                        QuestCameraLog.w(TAG) { "Camera ${cameraInfo.id} disconnected" }
+                        forgetCamera(camera, isLeft)
+                        failStartup(generation, isLeft, !isLeft)
+                    }
+                    
+                    override fun onError(camera: CameraDevice, error: Int) {
+                        val errorMsg = "Camera ${cameraInfo.id} error: $error"
+                        QuestCameraLog.e(TAG) { errorMsg }
+                        onCameraError(errorMsg)
+                        forgetCamera(camera, isLeft)
+                        failStartup(generation, isLeft, !isLeft)
+                    }
+                }, eyeCameraHandler(isLeft))
+                null
+            } catch (e: Exception) {
+                "Failed to open camera ${cameraInfo.id}: ${e.message}"
+            }
+        } ?: return true
+        QuestCameraLog.e(TAG) { failure }
+        onCameraError(failure)
+        return false
+    }
+    
+    // Closes a device that went away, leaving the field alone if a newer start replaced it
+    private fun forgetCamera(camera: CameraDevice, isLeft: Boolean) {
+        withEyeState(isLeft) {
+            camera.close()
+            if (isLeft && leftCamera === camera) {
+                leftCamera = null
+            } else if (!isLeft && rightCamera === camera) {
+                rightCamera = null
+            }
+        }
+    }
+    
+    private fun eyeCameraHandler(isLeft: Boolean): Handler = if (isLeft) leftCameraHandler else rightCameraHandler
+    
+    private fun closeImageReader(isLeft: Boolean) {
+        val reader = (if (isLeft) leftImageReader else rightImageReader) ?: return
+        // Closing frees the planes processImage may be reading right now. Detaching the
+        // listener drops frames not yet dispatched, and the close itself is queued behind
+        // the running one, so stopping never waits for the image thread.
+        reader.setOnImageAvailableListener(null, null)
+        if (isLeft) {
+            leftImageReader = null
+        } else {
+            rightImageReader = null
+        }
+        // Queued behind any processImage still running for this eye
+        (if (isLeft) leftImageHandler else rightImageHandler).post {
+            reader.close()
+            if (isLeft) {
+                leftStagingBuffer = null
+            } else {
+                rightStagingBuffer = null
+            }
+            uvInterleaved[if (isLeft) 0 else 1] = null
+            nativeReleaseStagingBuffer(isLeft)
+        }
+    }
+    
+    private fun stagingBuffer(isLeft: Boolean, size: Int): ByteBuffer? {
+        val current = if (isLeft) leftStagingBuffer else rightStagingBuffer
+        if (current != null && current.capacity() >= size) {
+            current.clear()
+            return current
+        }
+        val buffer = nativeAcquireStagingBuffer(isLeft, size) ?: return null
+        if (isLeft) {
+            leftStagingBuffer = buffer
+        } else {
+            rightStagingBuffer = buffer
+        }
+        return buffer
+    }
+    
+    // processImage reads the planes, so this reader is always YUV_420_888
+    private fun createImageReader(cameraInfo: CameraInfo, isLeft: Boolean): ImageReader {
         val imageReader = ImageReader.newInstance(
             cameraInfo.width, 
             cameraInfo.height, 
@@ -385,85 +1380,136 @@ class QuestCameraPlugin private constructor() {
             IMAGE_BUFFER_SIZE
         )
         
+        val gate = frameGates[if (isLeft) 0 else 1]
+        gate.resetProgress()
         imageReader.setOnImageAvailableListener({ reader ->
             val image = reader.acquireLatestImage()
+            val acquireTime = SystemClock.elapsedRealtimeNanos()
             image?.let {
-                processImage(it, cameraInfo, isLeft)
+                if (gate.admit(it.timestamp)) {
+                    processImage(it, cameraInfo, isLeft, acquireTime, gate.skippedBefore)
+                }
                 it.close()
             }
-        }, imageHandler)
+        }, if (isLeft) leftImageHandler else rightImageHandler)
         
         if (isLeft) {
             leftImageReader = imageReader
         } else {
             rightImageReader = imageReader
         }
+        return imageReader
+    }
+    
+    private fun createNativeReader(cameraInfo: CameraInfo, isLeft: Boolean): Surface? {
+        val surface = nativeCreateImageReader(
+            isLeft,
+            cameraInfo.width,
+            cameraInfo.height,
+            IMAGE_BUFFER_SIZE,
+            captureConfig.format,
+            useHardwareBufferOutput,
+            cameraInfo.intrinsics,
+            cameraInfo.distortion,
+            cameraInfo.pose
+        )
+        if (surface == null) {
+            QuestCameraLog.w(TAG) { "Native image reader unavailable, falling back to processImage" }
+            return null
+        }
         
-        try {
-            cameraManager.openCamera(cameraInfo.id, object : CameraDevice.StateCallback() {
-                override fun onOpened(camera: CameraDevice) {
-                    Log.d(TAG, "${if (isLeft) "Left" else "Right"} camera opened: ${cameraInfo.id}")
-                    if (isLeft) {
-                        leftCamera = camera
-                    } else {
-                        rightCamera = camera
-                    }
-                    createCaptureSession(camera, imageReader, isLeft)
-                }
-                
-                override fun onDisconnected(camera: CameraDevice) {
-                    Log.w(TAG, "Camera ${cameraInfo.id} disconnected")
-                    camera.close()
-                    if (isLeft) {
-                        leftCamera = null
-                    } else {
-                        rightCamera = null
-                    }
-                }
-                
-                override fun onError(camera: CameraDevice, error: Int) {
-                    val errorMsg = "Camera ${cameraInfo.id} error: $error"
-                    Log.e(TAG, errorMsg)
-                    onCameraError(errorMsg)
-                    camera.close()
-                    if (isLeft) {
-                        leftCamera = null
-                    } else {
-                        rightCamera = null
-                    }
-                }
-            }, cameraHandler)
-            return true
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to open camera ${cameraInfo.id}: ${e.message}")
-            onCameraError("Failed to open camera ${cameraInfo.id}: ${e.message}")
-            return false
+        if (isLeft) {
+            leftNativeSurface = surface
+        } else {
+            rightNativeSurface = surface
         }
+        return surface
     }
     
-    private fun createCaptureSession(camera: CameraDevice, imageReader: ImageReader, isLeft: Boolean) {
-        Log.d(TAG, "Creating capture session for ${if (isLeft) "left" else "right"} camera")
+    private fun releaseNativeReader(isLeft: Boolean) {
+        val surface = if (isLeft) leftNativeSurface else rightNativeSurface
+        surface ?: return
+        
+        nativeDestroyImageReader(isLeft)
+        surface.release()
+        if (isLeft) {
+            leftNativeSurface = null
+        } else {
+            rightNativeSurface = null
+        }
+    }
+    
+    // The encoder is one more camera output, so recording adds no copy to the frame path
+    private fun startRecorder(cameraInfo: CameraInfo, isLeft: Boolean): Surface? {
+        val config = recordingConfig ?: return null
+        val path = "${config.outputPrefix}_${if (isLeft) "left" else "right"}.mp4"
+        val surface = nativeStartRecording(
+            isLeft,
+            path,
+            cameraInfo.width,
+            cameraInfo.height,
+            captureConfig.fps,
+            config.bitrate,
+            config.hevc
+        )
+        if (surface == null) {
+            QuestCameraLog.w(TAG) { "Recording to $path unavailable, camera starts without it" }
+            return null
+        }
+        
+        if (isLeft) {
+            leftRecordingSurface = surface
+        } else {
+            rightRecordingSurface = surface
+        }
+        return surface
+    }
+    
+    // Call after the session is closed, so no new frame reaches the encoder
+    private fun stopRecorder(isLeft: Boolean) {
+        val surface = (if (isLeft) leftRecordingSurface else rightRecordingSurface) ?: return
+        nativeStopRecording(isLeft)
+        surface.release()
+        if (isLeft) {
+            leftRecordingSurface = null
+        } else {
+            rightRecordingSurface = null
+        }
+    }
+    
+    private fun createCaptureSession(camera: CameraDevice, surfaces: List<Surface>, isLeft: Boolean, generation: Int) {
+        QuestCameraLog.d(TAG) { "Creating capture session for ${if (isLeft) "left" else "right"} camera" }
         
-        val outputConfig = OutputConfiguration(imageReader.surface)
         val sessionConfig = SessionConfiguration(
             SessionConfiguration.SESSION_REGULAR,
-            listOf(outputConfig),
-            sessionExecutor,
+            surfaces.map { OutputConfiguration(it) },
+            // The eye's camera thread, so one session's callbacks never wait behind the other's
+            Executor { eyeCameraHandler(isLeft).post(it) },
             object : CameraCaptureSession.StateCallback() {
                 override fun onConfigured(session: CameraCaptureSession) {
-                    Log.d(TAG, "Capture session configured for ${if (isLeft) "left" else "right"} camera")
-                    if (isLeft) {
-                        leftSession = session
-                    } else {
-                        rightSession = session
+                    withEyeState(isLeft) {
+                        if (generation != startGeneration) {
+                            QuestCameraLog.d(TAG) { "${if (isLeft) "Left" else "Right"} session configured after stop, closing it" }
+                            session.close()
+                            return
+                        }
+                        QuestCameraLog.d(TAG) { "Capture session configured for ${if (isLeft) "left" else "right"} camera" }
+                        if (isLeft) {
+                            leftSession = session
+                        } else {
+                            rightSession = session
+                        }
+                        sessionSurfaces[if (isLeft) 0 else 1] = surfaces
+                        startRepeatingRequest(camera, surfaces, isLeft)
+                        nativeMarkStartupStage(isLeft, STARTUP_STAGE_CONFIGURED)
                     }
-                    startRepeatingRequest(camera, imageReader.surface)
                 }
                 
                 override fun onConfigureFailed(session: CameraCaptureSession) {
                     val errorMsg = "Session configuration failed for ${if (isLeft) "left" else "right"} camera"
-                    Log.e(TAG, errorMsg)
+                    QuestCameraLog.e(TAG) { errorMsg }
                     onCameraError(errorMsg)
+                    failStartup(generation, isLeft, !isLeft)
                 }
             }
         )
@@ -471,50 +1517,127 @@ class QuestCameraPlugin private constructor() {
         camera.createCaptureSession(sessionConfig)
     }
     
-    private fun startRepeatingRequest(camera: CameraDevice, surface: android.view.Surface) {
-        Log.d(TAG, "Starting repeating request")
+    private fun startRepeatingRequest(camera: CameraDevice, surfaces: List<Surface>, isLeft: Boolean) {
+        if (isPaused && standbyFpsRange == null) {
+            QuestCameraLog.d(TAG) { "Paused, repeating request starts on resume" }
+            return
+        }
+        QuestCameraLog.d(TAG) { "Starting repeating request" }
         
         val captureRequest = camera.createCaptureRequest(CameraDevice.TEMPLATE_PREVIEW).apply {
-            addTarget(surface)
+            surfaces.forEach { addTarget(it) }
+            applyCaptureSettings(this)
         }
         
-        val session = if (camera == leftCamera) leftSession else rightSession
-        session?.setRepeatingRequest(captureRequest.build(), null, cameraHandler)
+        val session = if (isLeft) leftSession else rightSession
+        session?.setRepeatingRequest(
+            captureRequest.build(),
+            if (isLeft) leftCaptureCallback else rightCaptureCallback,
+            eyeCameraHandler(isLeft)
+        )
+    }
+    
+    private fun captureResultCallback(isLeft: Boolean) = object : CameraCaptureSession.CaptureCallback() {
+        override fun onCaptureCompleted(session: CameraCaptureSession, request: CaptureRequest, result: TotalCaptureResult) {
+            recordCaptureResult(isLeft, result)
+        }
+    }
+    
+    // Only primitives cross JNI; the key is the raw sensor timestamp, the frame's stamp maps to it
+    private fun recordCaptureResult(isLeft: Boolean, result: CaptureResult) {
+        val sensorTimestamp = result.get(CaptureResult.SENSOR_TIMESTAMP) ?: return
+        nativeRecordCaptureResult(
+            isLeft,
+            sensorTimestamp,
+            result.get(CaptureResult.SENSOR_EXPOSURE_TIME) ?: 0L,
+            result.get(CaptureResult.SENSOR_FRAME_DURATION) ?: 0L,
+            result.get(CaptureResult.SENSOR_SENSITIVITY) ?: 0,
+            result.get(CaptureResult.SENSOR_ROLLING_SHUTTER_SKEW) ?: 0L
+        )
     }
     
-    private fun processImage(image: Image, cameraInfo: CameraInfo, isLeft: Boolean) {
+    // Tightly packed NV12 from the image planes into frameData, honoring row and pixel strides.
+    // On Quest the planes are already packed (plane 2 is plane 1 shifted by one byte), so Y and UV
+    // are bulk copied and only the last V byte, which plane 1 does not cover, is read from plane 2.
+    // Anything else, including interleaved VU order, is gathered per pixel. The order is fixed
+    // for a reader, so it is asked from the native side once per reader and eye.
+    @VisibleForTesting
+    internal fun packNv12(image: Image, width: Int, height: Int, frameData: ByteBuffer, isLeft: Boolean) {
+        val planes = image.planes
+        val yPlane = planes[0]
+        val uPlane = planes[1]
+        val vPlane = planes[2]
+        val ySize = width * height
+        
+        val yBuffer = yPlane.buffer
+        if (yPlane.rowStride == width) {
+            copyRange(yBuffer, 0, ySize, frameData, 0)
+        } else {
+            for (row in 0 until height) {
+                copyRange(yBuffer, row * yPlane.rowStride, width, frameData, row * width)
+            }
+        }
+        
+        val uBuffer = uPlane.buffer
+        val vBuffer = vPlane.buffer
+        val uvRowStride = uPlane.rowStride
+        val uvPixelStride = uPlane.pixelStride
+        val uvWidth = width / 2
+        val eye = if (isLeft) 0 else 1
+        val uFirst = uvInterleaved[eye]
+            ?: (uvPixelStride == 2 && nativeIsUvInterleaved(uBuffer, vBuffer)).also { uvInterleaved[eye] = it }
+        if (uFirst && uvRowStride == width) {
+            copyRange(uBuffer, 0, ySize / 2 - 1, frameData, ySize)
+            frameData.put(ySize + ySize / 2 - 1, vBuffer.get(ySize / 2 - 2))
+            return
+        }
+        for (row in 0 until height / 2) {
+            val dst = ySize + row * width
+            val src = row * uvRowStride
+            if (uFirst) {
+                // Interleaved, U plane row holds UVUV...U and the last V is in the V plane
+                copyRange(uBuffer, src, width - 1, frameData, dst)
+                frameData.put(dst + width - 1, vBuffer.get(src + (uvWidth - 1) * 2))
+            } else {
+                for (col in 0 until uvWidth) {
+                    frameData.put(dst + col * 2, uBuffer.get(src + col * uvPixelStride))
+                    frameData.put(dst + col * 2 + 1, vBuffer.get(src + col * uvPixelStride))
+                }
+            }
+        }
+    }
+    
+    private fun copyRange(src: ByteBuffer, srcOffset: Int, length: Int, dst: ByteBuffer, dstOffset: Int) {
+        val range = src.duplicate()
+        range.limit(srcOffset + length)
+        range.position(srcOffset)
+        dst.position(dstOffset)
+        dst.put(range)
+    }
+    
+    private fun processImage(
+        image: Image,
+        cameraInfo: CameraInfo,
+        isLeft: Boolean,
+        acquireTime: Long,
+        decimatedBefore: Int
+    ) {
         try {
-            val planes = image.planes
-            val yPlane = planes[0]
-            val uvPlane1 = planes[1]  // Interleaved UV data (mostly complete)
-            val uvPlane2 = planes[2]  // Contains the last V byte
-            
             val width = cameraInfo.width
             val height = cameraInfo.height
+            val frameSize = width * height * 3 / 2
+            val frameData = stagingBuffer(isLeft, frameSize) ?: run {
+                frameLogThrottles[if (isLeft) 0 else 1].e(TAG) {
+                    "No staging buffer for ${if (isLeft) "left" else "right"} frame"
+                }
+                return
+            }
+            packNv12(image, width, height, frameData, isLeft)
+            nativeRecordFrameTiming(isLeft, image.timestamp, acquireTime, decimatedBefore)
+            val frameTime = convertToFrameTime(isLeft, image.timestamp)
             
-            // Get buffer sizes
-            val ySize = yPlane.buffer.remaining()
-            val uv1Size = uvPlane1.buffer.remaining()
-            val uv2Size = uvPlane2.buffer.remaining()
-            
-            // Complete NV12: Y + UV plane 1 + last byte from UV plane 2
-            val frameData = ByteArray(ySize + uv1Size + 1)  // +1 for the missing byte
-            
-            Log.d(TAG, "${if (isLeft) "LEFT" else "RIGHT"} Camera: ${width}x${height}")
-            Log.d(TAG, "Y: $ySize, UV1: $uv1Size, UV2: $uv2Size, Total: ${frameData.size}")
-            
-            // Copy Y plane
-            yPlane.buffer.get(frameData, 0, ySize)
-            
-            // Copy UV plane 1 (interleaved UVUVUV... but missing last V)
-            uvPlane1.buffer.get(frameData, ySize, uv1Size)
-            
-            // Append the LAST V byte from plane 2
-            if (uv2Size > 0) {
-                val uv2Buffer = uvPlane2.buffer
-                val lastVByte = uv2Buffer.get(uv2Size - 1)  // THE LAST BYTE
-                frameData[ySize + uv1Size] = lastVByte
-                Log.d(TAG, "Added LAST V byte: $lastVByte from plane 2 (position ${uv2Size - 1})")
+            frameLogThrottles[if (isLeft) 0 else 1].d(TAG) {
+                "${if (isLeft) "LEFT" else "RIGHT"} Camera: ${width}x${height}, $frameSize bytes"
             }
             
             // Send individual frame callbacks only if enabled
@@ -524,20 +1647,14 @@ class QuestCameraPlugin private constructor() {
                         frameData,
                         width,
                         height,
-                        convertToGlobalTime(image.timestamp),
-                        cameraInfo.intrinsics,
-                        cameraInfo.distortion,
-                        cameraInfo.pose
+                        frameTime
                     )
                 } else {
                     onRightFrameAvailable(
                         frameData,
                         width,
                         height,
-                        convertToGlobalTime(image.timestamp),
-                        cameraInfo.intrinsics,
-                        cameraInfo.distortion,
-                        cameraInfo.pose
+                        frameTime
                     )
                 }
             }
@@ -546,17 +1663,15 @@ class QuestCameraPlugin private constructor() {
             if (enableStereoCombining && isLeftCameraActive && isRightCameraActive) {
                 val frameDataWrapper = StereoFrameCombiner.FrameData(
                     frameData,
-                    convertToGlobalTime(image.timestamp),
-                    cameraInfo.intrinsics,
-                    cameraInfo.distortion,
-                    cameraInfo.pose
+                    width,
+                    height,
+                    frameTime
                 )
                 
                 stereoFrameCombiner.onFrameAvailable(isLeft, frameDataWrapper)
             }
         } catch (e: Exception) {
-            Log.e(TAG, "Error processing ${if (isLeft) "LEFT" else "RIGHT"} image: ${e.message}")
-            e.printStackTrace()
+            errorLogThrottle.e(TAG) { "Error processing ${if (isLeft) "LEFT" else "RIGHT"} image: ${e.message}" }
         }
     }
     